@@ -0,0 +1,192 @@
+#pragma once
+// Minimal stand-in for the Pebble SDK header so the core game logic can be
+// built and exercised on a Linux host. Only the calls used by the non-UI
+// sources are provided. Time is virtual and only moves when the driver
+// advances it, timers fire from shim_run_until().
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+// Logging
+typedef enum {
+  APP_LOG_LEVEL_ERROR = 1,
+  APP_LOG_LEVEL_WARNING = 50,
+  APP_LOG_LEVEL_INFO = 100,
+  APP_LOG_LEVEL_DEBUG = 200,
+  APP_LOG_LEVEL_DEBUG_VERBOSE = 255
+} AppLogLevel;
+
+void shim_log(uint8_t level, const char* file, int line, const char* fmt, ...);
+#define APP_LOG(level, ...) shim_log(level, __FILE__, __LINE__, __VA_ARGS__)
+
+// Status codes
+typedef enum {
+  S_SUCCESS = 0,
+  E_ERROR = -1,
+  E_UNKNOWN = -2,
+  E_INTERNAL = -3,
+  E_INVALID_ARGUMENT = -4,
+  E_OUT_OF_MEMORY = -5,
+  E_OUT_OF_STORAGE = -6,
+  E_OUT_OF_RESOURCES = -7,
+  E_RANGE = -8,
+  E_DOES_NOT_EXIST = -9,
+  E_INVALID_OPERATION = -10,
+  E_BUSY = -11,
+  S_TRUE = 1,
+  S_FALSE = 0,
+  S_NO_MORE_ITEMS = 2,
+  S_NO_ACTION_REQUIRED = 3
+} StatusCode;
+
+// Time
+uint16_t time_ms(time_t* tloc, uint16_t* out_ms);
+// Whole seconds on the same virtual clock
+time_t shim_time(time_t* tloc);
+#define time(tloc) shim_time(tloc)
+
+// Accelerometer samples, in mg with the time they were taken in ms
+typedef struct {
+  int16_t x;
+  int16_t y;
+  int16_t z;
+  bool did_vibrate;
+  uint64_t timestamp;
+} AccelData;
+
+// Timers
+typedef struct AppTimer AppTimer;
+typedef void (*AppTimerCallback)(void* data);
+AppTimer* app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void* callback_data);
+bool app_timer_reschedule(AppTimer* timer, uint32_t new_timeout_ms);
+void app_timer_cancel(AppTimer* timer);
+
+// Persistent storage
+#define PERSIST_DATA_MAX_LENGTH 256
+bool persist_exists(const uint32_t key);
+int persist_get_size(const uint32_t key);
+int persist_read_data(const uint32_t key, void* buffer, const size_t buffer_size);
+int persist_write_data(const uint32_t key, const void* data, const size_t size);
+StatusCode persist_delete(const uint32_t key);
+
+// Dictionaries
+typedef enum {
+  TUPLE_BYTE_ARRAY = 0,
+  TUPLE_CSTRING = 1,
+  TUPLE_UINT = 2,
+  TUPLE_INT = 3
+} TupleType;
+
+typedef struct __attribute__((__packed__)) {
+  uint32_t key;
+  TupleType type:8;
+  uint16_t length;
+  union {
+    uint8_t data[0];
+    char cstring[0];
+    uint8_t uint8;
+    uint16_t uint16;
+    uint32_t uint32;
+    int8_t int8;
+    int16_t int16;
+    int32_t int32;
+  } value[];
+} Tuple;
+
+typedef struct {
+  uint8_t* begin;
+  uint8_t* end;
+  uint8_t* cursor;
+} DictionaryIterator;
+
+Tuple* dict_read_begin_from_buffer(DictionaryIterator* iter, const uint8_t* buffer, const uint16_t size);
+Tuple* dict_read_first(DictionaryIterator* iter);
+Tuple* dict_read_next(DictionaryIterator* iter);
+Tuple* dict_find(const DictionaryIterator* iter, const uint32_t key);
+
+// Background worker. Messages are handed straight to the subscribed
+// handler, and the app is only relaunched when the driver sees the launch.
+// Launching and killing the worker run the driver's shim_worker_start and
+// shim_worker_stop in place of its main().
+typedef struct {
+  uint16_t data0;
+  uint16_t data1;
+  uint16_t data2;
+} AppWorkerMessage;
+
+typedef void (*AppWorkerMessageHandler)(uint16_t type, AppWorkerMessage* data);
+
+typedef enum {
+  APP_LAUNCH_SYSTEM,
+  APP_LAUNCH_USER,
+  APP_LAUNCH_PHONE,
+  APP_LAUNCH_WAKEUP,
+  APP_LAUNCH_WORKER,
+  APP_LAUNCH_QUICK_LAUNCH,
+  APP_LAUNCH_TIMELINE_ACTION
+} AppLaunchReason;
+
+AppLaunchReason launch_reason();
+bool app_worker_is_running();
+int app_worker_launch();
+bool app_worker_kill();
+bool app_worker_message_subscribe(AppWorkerMessageHandler handler);
+bool app_worker_message_unsubscribe();
+void app_worker_send_message(uint8_t type, AppWorkerMessage* data);
+void worker_launch_app();
+
+// Heap tracking: every allocation made by the app code is counted
+void* shim_malloc(size_t size);
+void* shim_calloc(size_t count, size_t size);
+void* shim_realloc(void* ptr, size_t size);
+void shim_free(void* ptr);
+// The app heap is SHIM_HEAP_SIZE bytes, as on the original Pebble
+#define SHIM_HEAP_SIZE (24 * 1024)
+size_t heap_bytes_used();
+size_t heap_bytes_free();
+#ifndef PEBBLE_SHIM_INTERNAL
+#define malloc shim_malloc
+#define calloc shim_calloc
+#define realloc shim_realloc
+#define free shim_free
+#endif
+
+// Host-side control of the simulated watch
+typedef struct ShimStats_t {
+  uint32_t wakeups;
+  uint32_t timers_registered;
+  uint32_t timers_cancelled;
+  uint32_t persist_writes;
+  uint32_t persist_bytes_written;
+  uint32_t persist_reads;
+  uint32_t persist_bytes_read;
+  // persist_exists and persist_get_size
+  uint32_t persist_lookups;
+  size_t heap_current;
+  size_t heap_peak;
+  uint32_t allocations;
+  uint32_t worker_starts;
+  uint32_t worker_messages;
+  // Of the app, by the worker
+  uint32_t worker_launches;
+} ShimStats;
+
+extern ShimStats shim_stats;
+
+void shim_reset(time_t start);
+uint64_t shim_now_ms();
+void shim_advance(uint32_t ms);
+// Fire every timer due up to and including the given virtual time
+void shim_run_until(uint64_t ms);
+// Due time of the earliest pending timer, UINT64_MAX if none are pending
+uint64_t shim_next_timer();
+void shim_set_log_level(uint8_t level);
+void shim_persist_clear();
+// Why the app is being opened, set to APP_LAUNCH_WORKER by worker_launch_app()
+extern AppLaunchReason shim_launch_reason;
+extern void (*shim_worker_start)(void);
+extern void (*shim_worker_stop)(void);
@@ -0,0 +1,341 @@
+#define PEBBLE_SHIM_INTERNAL
+#include <stdarg.h>
+#include "pebble.h"
+
+ShimStats shim_stats;
+
+static time_t s_epoch;
+static uint64_t s_now_ms;
+static uint8_t s_log_level = APP_LOG_LEVEL_WARNING;
+
+void shim_log(uint8_t level, const char* file, int line, const char* fmt, ...) {
+  if (level > s_log_level) return;
+  va_list args;
+  va_start(args, fmt);
+  fprintf(stderr, "[%llu] %s:%d ", (unsigned long long)s_now_ms, file, line);
+  vfprintf(stderr, fmt, args);
+  fputc('\n', stderr);
+  va_end(args);
+}
+
+void shim_set_log_level(uint8_t level) {
+  s_log_level = level;
+}
+
+// Virtual clock
+
+uint16_t time_ms(time_t* tloc, uint16_t* out_ms) {
+  uint16_t ms = s_now_ms % 1000;
+  if (tloc) *tloc = s_epoch + (time_t)(s_now_ms / 1000);
+  if (out_ms) *out_ms = ms;
+  return ms;
+}
+
+time_t shim_time(time_t* tloc) {
+  time_t now = s_epoch + (time_t)(s_now_ms / 1000);
+  if (tloc) *tloc = now;
+  return now;
+}
+
+uint64_t shim_now_ms() {
+  return s_now_ms;
+}
+
+void shim_advance(uint32_t ms) {
+  s_now_ms += ms;
+}
+
+// Timers, kept in a list sorted by due time
+
+struct AppTimer {
+  uint64_t due;
+  AppTimerCallback callback;
+  void* data;
+  AppTimer* next;
+};
+
+static AppTimer* s_timers;
+
+static void timer_insert(AppTimer* timer) {
+  AppTimer** pos = &s_timers;
+  while (*pos && (*pos)->due <= timer->due) pos = &(*pos)->next;
+  timer->next = *pos;
+  *pos = timer;
+}
+
+static bool timer_unlink(AppTimer* timer) {
+  for (AppTimer** pos = &s_timers; *pos; pos = &(*pos)->next) {
+    if (*pos == timer) {
+      *pos = timer->next;
+      return true;
+    }
+  }
+  return false;
+}
+
+AppTimer* app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void* callback_data) {
+  AppTimer* timer = malloc(sizeof(AppTimer));
+  timer->due = s_now_ms + timeout_ms;
+  timer->callback = callback;
+  timer->data = callback_data;
+  timer_insert(timer);
+  shim_stats.timers_registered++;
+  return timer;
+}
+
+bool app_timer_reschedule(AppTimer* timer, uint32_t new_timeout_ms) {
+  if (!timer_unlink(timer)) return false;
+  timer->due = s_now_ms + new_timeout_ms;
+  timer_insert(timer);
+  return true;
+}
+
+void app_timer_cancel(AppTimer* timer) {
+  if (timer_unlink(timer)) {
+    free(timer);
+    shim_stats.timers_cancelled++;
+  }
+}
+
+uint64_t shim_next_timer() {
+  return s_timers ? s_timers->due : UINT64_MAX;
+}
+
+void shim_run_until(uint64_t ms) {
+  while (s_timers && s_timers->due <= ms) {
+    AppTimer* timer = s_timers;
+    s_timers = timer->next;
+    if (timer->due > s_now_ms) s_now_ms = timer->due;
+    shim_stats.wakeups++;
+    AppTimerCallback callback = timer->callback;
+    void* data = timer->data;
+    free(timer);
+    callback(data);
+  }
+  if (ms > s_now_ms) s_now_ms = ms;
+}
+
+// Persistent storage, held in memory
+
+typedef struct PersistEntry_t {
+  uint32_t key;
+  uint16_t size;
+  uint8_t data[PERSIST_DATA_MAX_LENGTH];
+  struct PersistEntry_t* next;
+} PersistEntry;
+
+static PersistEntry* s_persist;
+
+static PersistEntry* persist_find(uint32_t key) {
+  for (PersistEntry* entry = s_persist; entry; entry = entry->next) {
+    if (entry->key == key) return entry;
+  }
+  return NULL;
+}
+
+bool persist_exists(const uint32_t key) {
+  shim_stats.persist_lookups++;
+  return persist_find(key) != NULL;
+}
+
+int persist_get_size(const uint32_t key) {
+  shim_stats.persist_lookups++;
+  PersistEntry* entry = persist_find(key);
+  return entry ? entry->size : E_DOES_NOT_EXIST;
+}
+
+int persist_read_data(const uint32_t key, void* buffer, const size_t buffer_size) {
+  PersistEntry* entry = persist_find(key);
+  if (!entry) return E_DOES_NOT_EXIST;
+  size_t size = entry->size < buffer_size ? entry->size : buffer_size;
+  memcpy(buffer, entry->data, size);
+  shim_stats.persist_reads++;
+  shim_stats.persist_bytes_read += size;
+  return size;
+}
+
+int persist_write_data(const uint32_t key, const void* data, const size_t size) {
+  PersistEntry* entry = persist_find(key);
+  if (!entry) {
+    entry = calloc(1, sizeof(PersistEntry));
+    entry->key = key;
+    entry->next = s_persist;
+    s_persist = entry;
+  }
+  size_t written = size < PERSIST_DATA_MAX_LENGTH ? size : PERSIST_DATA_MAX_LENGTH;
+  memcpy(entry->data, data, written);
+  entry->size = written;
+  shim_stats.persist_writes++;
+  shim_stats.persist_bytes_written += written;
+  return written;
+}
+
+StatusCode persist_delete(const uint32_t key) {
+  for (PersistEntry** pos = &s_persist; *pos; pos = &(*pos)->next) {
+    if ((*pos)->key == key) {
+      PersistEntry* entry = *pos;
+      *pos = entry->next;
+      free(entry);
+      return S_TRUE;
+    }
+  }
+  return E_DOES_NOT_EXIST;
+}
+
+void shim_persist_clear() {
+  while (s_persist) {
+    PersistEntry* entry = s_persist;
+    s_persist = entry->next;
+    free(entry);
+  }
+}
+
+// Dictionaries, laid out as the packed tuples the watch receives
+
+static Tuple* dict_current(DictionaryIterator* iter) {
+  if (iter->cursor + sizeof(Tuple) > iter->end) return NULL;
+  return (Tuple*)iter->cursor;
+}
+
+Tuple* dict_read_begin_from_buffer(DictionaryIterator* iter, const uint8_t* buffer, const uint16_t size) {
+  iter->begin = (uint8_t*)buffer;
+  iter->end = (uint8_t*)buffer + size;
+  return dict_read_first(iter);
+}
+
+Tuple* dict_read_first(DictionaryIterator* iter) {
+  iter->cursor = iter->begin;
+  return dict_current(iter);
+}
+
+Tuple* dict_read_next(DictionaryIterator* iter) {
+  Tuple* tuple = dict_current(iter);
+  if (!tuple) return NULL;
+  iter->cursor += sizeof(Tuple) + tuple->length;
+  return dict_current(iter);
+}
+
+Tuple* dict_find(const DictionaryIterator* iter, const uint32_t key) {
+  DictionaryIterator copy = *iter;
+  for (Tuple* t = dict_read_first(&copy); t; t = dict_read_next(&copy)) {
+    if (t->key == key) return t;
+  }
+  return NULL;
+}
+
+// Background worker
+
+AppLaunchReason shim_launch_reason = APP_LAUNCH_USER;
+void (*shim_worker_start)(void);
+void (*shim_worker_stop)(void);
+static bool s_worker_running;
+static AppWorkerMessageHandler s_worker_handler;
+
+AppLaunchReason launch_reason() {
+  return shim_launch_reason;
+}
+
+bool app_worker_is_running() {
+  return s_worker_running;
+}
+
+int app_worker_launch() {
+  if (s_worker_running) return 0;
+  s_worker_running = true;
+  shim_stats.worker_starts++;
+  if (shim_worker_start) shim_worker_start();
+  return 0;
+}
+
+bool app_worker_kill() {
+  if (!s_worker_running) return false;
+  s_worker_running = false;
+  if (shim_worker_stop) shim_worker_stop();
+  return true;
+}
+
+bool app_worker_message_subscribe(AppWorkerMessageHandler handler) {
+  s_worker_handler = handler;
+  return true;
+}
+
+bool app_worker_message_unsubscribe() {
+  s_worker_handler = NULL;
+  return true;
+}
+
+void app_worker_send_message(uint8_t type, AppWorkerMessage* data) {
+  shim_stats.worker_messages++;
+  if (s_worker_running && s_worker_handler) s_worker_handler(type, data);
+}
+
+void worker_launch_app() {
+  shim_stats.worker_launches++;
+  shim_launch_reason = APP_LAUNCH_WORKER;
+}
+
+// Heap tracking, each block carries its size in a header
+
+typedef union {
+  size_t size;
+  long double align;
+} AllocHeader;
+
+void* shim_malloc(size_t size) {
+  AllocHeader* header = malloc(sizeof(AllocHeader) + size);
+  if (!header) return NULL;
+  header->size = size;
+  shim_stats.allocations++;
+  shim_stats.heap_current += size;
+  if (shim_stats.heap_current > shim_stats.heap_peak) shim_stats.heap_peak = shim_stats.heap_current;
+  return header + 1;
+}
+
+size_t heap_bytes_used() {
+  return shim_stats.heap_current;
+}
+
+size_t heap_bytes_free() {
+  return shim_stats.heap_current < SHIM_HEAP_SIZE ? SHIM_HEAP_SIZE - shim_stats.heap_current : 0;
+}
+
+void* shim_calloc(size_t count, size_t size) {
+  void* ptr = shim_malloc(count * size);
+  if (ptr) memset(ptr, 0, count * size);
+  return ptr;
+}
+
+void shim_free(void* ptr) {
+  if (!ptr) return;
+  AllocHeader* header = (AllocHeader*)ptr - 1;
+  shim_stats.heap_current -= header->size;
+  free(header);
+}
+
+void* shim_realloc(void* ptr, size_t size) {
+  if (!ptr) return shim_malloc(size);
+  AllocHeader* header = (AllocHeader*)ptr - 1;
+  size_t old_size = header->size;
+  void* result = shim_malloc(size);
+  if (!result) return NULL;
+  memcpy(result, ptr, old_size < size ? old_size : size);
+  shim_free(ptr);
+  return result;
+}
+
+void shim_reset(time_t start) {
+  while (s_timers) {
+    AppTimer* timer = s_timers;
+    s_timers = timer->next;
+    free(timer);
+  }
+  s_epoch = start;
+  s_now_ms = 0;
+  shim_launch_reason = APP_LAUNCH_USER;
+  s_worker_running = false;
+  // Blocks still owned by the app stay counted
+  size_t heap_current = shim_stats.heap_current;
+  memset(&shim_stats, 0, sizeof(shim_stats));
+  shim_stats.heap_current = heap_current;
+  shim_stats.heap_peak = heap_current;
+}
@@ -0,0 +1,3 @@
+#pragma once
+// The worker builds against the same shim as the app
+#include "pebble.h"
@@ -0,0 +1,1076 @@
+// Replays scripted games against the core game logic on a virtual clock and
+// reports how much work the watch would have done.
+//
+//   replay [-g games] [-s seed] [-w watches] [-l latency] [-d drop] [-v] [script...]
+//
+// With no scripts, full four-quarter games are generated from the seed.
+// With more than one watch they are kept in step over a loopback radio that
+// delays each frame by the latency in milliseconds and loses the given
+// percentage of them. Script lines mirror the watch's buttons and menus:
+//
+//   watch <n>                         following lines act on watch n
+//   wait <seconds>                    let the virtual clock run
+//   down                              bottom button, start/stop the clock
+//   reset                             Time menu, Reset
+//   quarter                           Time menu, End Quarter
+//   clock game|play|timeout|half      Time menu, Change Clock
+//   score home|away td|fg|safety      New score
+//   try 2|1|0                         Try result for the last touchdown
+//   penalty home|away <number>        New penalty
+//   timeout home|away                 New timeout
+//   undo                              Main menu, Undo
+//   chord up|select 2|3               Double or triple click on the main
+//                                     window, logging its shortcut
+//   accel <file>                      Wrist movement from a file of samples
+//                                     taken at TAP_SAMPLING_HZ, one "x y z"
+//                                     in mg per line with a trailing v while
+//                                     the motor ran, relative to the script
+//   relaunch                          Exit and reopen the app
+//   kill                              App dies without saving, then reopens
+//   damage                            Corrupt the newest saved snapshot
+//   oldsave                           Save the game as version 9 did
+//   away <seconds>                    Leave the app, the worker holds the
+//                                     clock and may open it again sooner
+//   newgame                           Main menu, Reset Game, archiving the
+//                                     game first
+//   config <field> <value>...         Config message from the phone, fields
+//                                     game, play, timeouts, periods, postsnap,
+//                                     gamewarning, playwarning, breakwarning,
+//                                     up2, up3, select2, select3, tap and
+//                                     reset (value ignored)
+//   show                              Print the score, quarter and clock
+//   counts                            Print the warnings and expiries so far
+//   outbox fail <count>               The outbox refuses the next count
+//                                     messages handed to it
+//   expect <text>                     Fail the run unless the next line
+//                                     printed by the command before matches
+//   check                             Let the radio go quiet, then check
+//                                     every watch shows the same game
+#define _POSIX_C_SOURCE 200809L
+#include <stdarg.h>
+#include <pebble.h>
+#include "GameData.h"
+#include "AppConfig.h"
+#include "Sync.h"
+#include "WorkerLink.h"
+#include "ClockWorker.h"
+#include "Trace.h"
+#include "HeapStats.h"
+#include "Activity.h"
+#include "Archive.h"
+#include "TapDetector.h"
+
+static const uint32_t GAME_DATA_KEY = 0;
+static const uint32_t ARCHIVE_KEY = 200;
+// Each watch keeps its game under its own range of persist keys
+static const uint32_t WATCH_KEY_STRIDE = 1000;
+static const time_t SIM_EPOCH = 1420070400;
+
+#define WATCHES_MAX 8
+
+typedef struct Watch_t {
+  GameData game;
+  Sync sync;
+  ClockWorker worker;
+  uint16_t launches;
+  uint16_t shown_seconds;
+  uint16_t game_seconds;
+  // The config reply to the phone, as in main.c
+  bool reply_waiting;
+  bool reply_in_flight;
+  uint8_t reply_failures;
+  AppTimer* reply_retry;
+  // Hand-overs the outbox is still to refuse
+  uint8_t outbox_refusals;
+} Watch;
+
+static Watch watches[WATCHES_MAX];
+static uint8_t watch_count = 1;
+// The watch taking input
+static Watch* watch = &watches[0];
+static bool verbose;
+
+// CPU time per operation
+
+typedef enum {
+  OP_TIMER,
+  OP_DOWN,
+  OP_RESET,
+  OP_QUARTER,
+  OP_CLOCK,
+  OP_SCORE,
+  OP_TRY,
+  OP_PENALTY,
+  OP_TIMEOUT,
+  OP_UNDO,
+  OP_WRITE,
+  OP_READ,
+  OP_NEWGAME,
+  OP_CONFIG,
+  OP_ARCHIVE,
+  OP_SHORTCUT,
+  OP_TAPS,
+  OP_COUNT
+} Operation;
+
+static const char* op_names[OP_COUNT] = {
+  "timer fire", "down", "reset", "quarter", "clock", "score", "try",
+  "penalty", "timeout", "undo", "game_data_write", "game_data_read", "newgame",
+  "app_config_reload", "archive_add", "game_data_shortcut",
+  "tap_detector_feed"
+};
+
+typedef struct Profile_t {
+  uint32_t calls;
+  uint64_t total_ns;
+  uint64_t max_ns;
+} Profile;
+
+static Profile profiles[OP_COUNT];
+
+static uint64_t cpu_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+#define PROFILE(op, call) do { \
+    uint64_t start_ns = cpu_ns(); \
+    call; \
+    uint64_t elapsed_ns = cpu_ns() - start_ns; \
+    profiles[op].calls++; \
+    profiles[op].total_ns += elapsed_ns; \
+    if (elapsed_ns > profiles[op].max_ns) profiles[op].max_ns = elapsed_ns; \
+  } while (0)
+
+// Simulated display, counts how often the clock text would change
+
+static uint32_t ticks;
+static uint32_t display_changes;
+static uint32_t warnings;
+static uint32_t expiries;
+static uint32_t worker_alerts;
+
+// Callbacks are not told which watch they belong to, so look at them all.
+// The game clock is on screen under any other clock.
+static void on_tick(void* ctx) {
+  ticks++;
+  for (uint8_t i = 0; i < watch_count; ++i) {
+    GameData* game = &watches[i].game;
+    uint16_t seconds = game_data_clock_get_seconds(game, game->shown);
+    uint16_t game_seconds = game->shown == CLOCK_GAME ? UINT16_MAX : game_data_clock_get_seconds(game, CLOCK_GAME);
+    if (seconds != watches[i].shown_seconds || game_seconds != watches[i].game_seconds) {
+      watches[i].shown_seconds = seconds;
+      watches[i].game_seconds = game_seconds;
+      display_changes++;
+    }
+  }
+}
+
+static void on_warning(ClockId clock) {
+  warnings++;
+}
+
+static void on_expire(ClockId clock) {
+  expiries++;
+}
+
+// Loopback radio. Every frame reaches each other watch after the latency
+// unless it is lost, and the sender hears it went out at the same time.
+// Anything arriving after the app was relaunched is lost with it.
+
+#define MESSAGES_MAX 64
+
+typedef struct Message_t {
+  bool in_use;
+  bool ack;
+  // The phone has the config reply, only ever sent to the watch itself
+  bool reply;
+  Watch* to;
+  uint16_t launch;
+  uint8_t size;
+  uint8_t data[SYNC_FRAME_MAX];
+} Message;
+
+static Message messages[MESSAGES_MAX];
+static uint32_t latency_ms = 200;
+static uint32_t drop_percent;
+static uint32_t radio_state = 1;
+static uint32_t frames_delivered;
+static uint32_t frames_dropped;
+static uint32_t sync_checks;
+static uint32_t sync_diverged;
+static uint32_t replies_sent;
+static uint32_t replies_dropped;
+static SyncStats sync_totals;
+
+static uint32_t xorshift(uint32_t* state) {
+  *state ^= *state << 13;
+  *state ^= *state >> 17;
+  *state ^= *state << 5;
+  return *state;
+}
+
+static void reply_sent(Watch* to);
+static void send_reply(Watch* from);
+
+static void radio_handle(void* context) {
+  Message* message = (Message*)context;
+  Watch* to = message->to;
+  if (message->launch != to->launches) {
+    // Lost along with the app it was meant for
+  } else if (message->reply) {
+    reply_sent(to);
+  } else if (message->ack) {
+    sync_sent(&to->sync, true);
+    send_reply(to);
+  } else {
+    frames_delivered++;
+    sync_receive(&to->sync, message->data, message->size);
+  }
+  // Only now, as receiving may send again
+  message->in_use = false;
+}
+
+static bool radio_post(Watch* to, bool ack, bool reply, const uint8_t* data, uint16_t size) {
+  for (int i = 0; i < MESSAGES_MAX; ++i) {
+    Message* message = &messages[i];
+    if (message->in_use) continue;
+    *message = (Message) {
+      .in_use = true, .ack = ack, .reply = reply, .to = to, .launch = to->launches, .size = size
+    };
+    if (size) memcpy(message->data, data, size);
+    app_timer_register(latency_ms, radio_handle, message);
+    return true;
+  }
+  return false;
+}
+
+// The outbox holds one message at a time, whatever it is for
+static bool outbox_take(Watch* from) {
+  if (from->reply_in_flight) return false;
+  if (from->outbox_refusals) {
+    from->outbox_refusals--;
+    return false;
+  }
+  return true;
+}
+
+// Frames wait while a config reply does, as send_sync_frame() in main.c
+static bool radio_send(void* context, const uint8_t* data, uint16_t size) {
+  Watch* from = (Watch*)context;
+  if (from->reply_waiting || !outbox_take(from)) return false;
+  for (uint8_t i = 0; i < watch_count; ++i) {
+    Watch* to = &watches[i];
+    if (to == from) continue;
+    if (xorshift(&radio_state) % 100 < drop_percent || !radio_post(to, false, false, data, size)) {
+      frames_dropped++;
+    }
+  }
+  return radio_post(from, true, false, NULL, 0);
+}
+
+// The config reply as send_config_reply() in main.c. One the outbox will not
+// take is tried again after a growing wait, then dropped so that the frames
+// held back behind it can go.
+#define CONFIG_RETRY_MS 500
+#define CONFIG_FAILURES_MAX 5
+
+static void reply_retry(void* context) {
+  Watch* from = (Watch*)context;
+  from->reply_retry = NULL;
+  send_reply(from);
+}
+
+static void send_reply(Watch* from) {
+  if (!from->reply_waiting || from->reply_in_flight || from->reply_retry || from->sync.busy) return;
+  if (outbox_take(from) && radio_post(from, false, true, NULL, 0)) {
+    from->reply_waiting = false;
+    from->reply_in_flight = true;
+    from->reply_failures = 0;
+    return;
+  }
+  if (++from->reply_failures < CONFIG_FAILURES_MAX) {
+    from->reply_retry = app_timer_register(CONFIG_RETRY_MS << (from->reply_failures - 1), reply_retry, from);
+    return;
+  }
+  replies_dropped++;
+  from->reply_waiting = false;
+  from->reply_failures = 0;
+  if (watch_count > 1) sync_flush(&from->sync);
+}
+
+// A reply still to go is lost with the app
+static void reply_clear(Watch* from) {
+  if (from->reply_retry) app_timer_cancel(from->reply_retry);
+  from->reply_retry = NULL;
+  from->reply_waiting = false;
+  from->reply_in_flight = false;
+  from->reply_failures = 0;
+}
+
+static void reply_sent(Watch* to) {
+  replies_sent++;
+  to->reply_in_flight = false;
+  if (watch_count > 1) sync_flush(&to->sync);
+  send_reply(to);
+}
+
+static bool radio_idle() {
+  for (int i = 0; i < MESSAGES_MAX; ++i) {
+    if (messages[i].in_use) return false;
+  }
+  for (uint8_t i = 0; i < watch_count; ++i) {
+    if (watches[i].reply_waiting || watches[i].reply_in_flight) return false;
+    Sync* sync = &watches[i].sync;
+    if (sync->pending_size || sync->busy || sync->sent != sync->seq || sync->resync || sync->control_size
+        || sync->tail_timer) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void sync_stats_add(const SyncStats* stats) {
+  sync_totals.frames_sent += stats->frames_sent;
+  sync_totals.bytes_sent += stats->bytes_sent;
+  sync_totals.send_failures += stats->send_failures;
+  sync_totals.frames_received += stats->frames_received;
+  sync_totals.records_applied += stats->records_applied;
+  sync_totals.duplicates += stats->duplicates;
+  sync_totals.resend_requests += stats->resend_requests;
+  sync_totals.frames_resent += stats->frames_resent;
+  sync_totals.resyncs_sent += stats->resyncs_sent;
+}
+
+// App lifecycle, as init()/deinit() in main.c. Only the watch being opened
+// or closed talks to its worker.
+
+static void worker_message(uint16_t type, AppWorkerMessage* message) {
+  clock_worker_message(&watch->worker, type, message);
+}
+
+// The worker's main() in worker_src/, launched and killed by WorkerLink
+static void worker_start() {
+  clock_worker_init(&watch->worker);
+  app_worker_message_subscribe(worker_message);
+}
+
+static void worker_stop() {
+  app_worker_message_unsubscribe();
+  clock_worker_deinit(&watch->worker);
+}
+
+static uint32_t watch_key() {
+  return GAME_DATA_KEY + (uint32_t)(watch - watches) * WATCH_KEY_STRIDE;
+}
+
+static void app_open() {
+  app_config_init();
+  heap_stats_init();
+  game_data_init(&watch->game);
+  bool loaded;
+  PROFILE(OP_READ, loaded = game_data_read(&watch->game, watch_key()));
+  if (!loaded) game_data_reset(&watch->game);
+  if (worker_link_take_over()) worker_alerts++;
+  shim_launch_reason = APP_LAUNCH_USER;
+  watch->shown_seconds = UINT16_MAX;
+  watch->game_seconds = UINT16_MAX;
+  for (int i = 0; i < CLOCK_COUNT; ++i) {
+    game_data_clock_set_callbacks(&watch->game, i, (ClockCallbacks) {
+      .on_warning = on_warning, .on_expire = on_expire
+    });
+  }
+  game_data_set_tick_callback(&watch->game, on_tick);
+  // New id per launch, as on the watch
+  watch->launches++;
+  uint16_t id = (uint16_t)((watch - watches) << 12 | watch->launches);
+  if (watch_count > 1) sync_init(&watch->sync, &watch->game, id, radio_send, watch);
+}
+
+static void app_close() {
+  reply_clear(watch);
+  if (watch_count > 1) {
+    sync_deinit(&watch->sync);
+    sync_stats_add(&watch->sync.stats);
+  }
+  PROFILE(OP_WRITE, game_data_write(&watch->game, watch_key()));
+  worker_link_hand_over(&watch->game);
+  game_data_free(&watch->game);
+  heap_stats_write();
+}
+
+// Damaged and older saves, to check the game still comes back. The key
+// layout follows GameData.c: two banks of BANK_KEYS keys, each a record
+// then the events that do not fit in it.
+static const uint32_t BANK_KEYS = 5;
+static const uint8_t EVENT_LOG_KEYS = 4;
+
+// Flips the last byte of the bank written most recently, as a write cut
+// short would leave it, so only its crc tells it apart
+static void damage_snapshot() {
+  uint32_t key = watch_key() + (watch->game.generation % 2) * BANK_KEYS;
+  uint8_t record[PERSIST_DATA_MAX_LENGTH];
+  int size = persist_read_data(key, record, sizeof(record));
+  if (size <= 0) return;
+  record[size - 1] ^= 0xFF;
+  persist_write_data(key, record, size);
+}
+
+// The layout of GameDataStorageV9 in GameData.c, the storage alone with
+// the events in the keys after it
+typedef struct StorageV9_t {
+  uint32_t version;
+  Timer clocks[CLOCK_COUNT];
+  uint8_t home_timeouts;
+  uint8_t away_timeouts;
+  uint8_t quarter;
+  uint8_t try_active;
+  uint8_t home_team_active;
+  uint8_t shown;
+  uint8_t post_snap;
+  uint16_t journal_seq;
+  uint16_t revision;
+} StorageV9;
+
+// Saves the open game as version 9 did, in place of both banks
+static void save_v9() {
+  GameData* game = &watch->game;
+  StorageV9 storage = {
+    .version = 9,
+    .home_timeouts = game->home.timeouts,
+    .away_timeouts = game->away.timeouts,
+    .quarter = game->quarter,
+    .try_active = game->try_active,
+    .home_team_active = game->home_team_active,
+    .shown = game->shown,
+    .post_snap = game->post_snap,
+    .journal_seq = journal_seq(&game->journal),
+    .revision = game->revision
+  };
+  memcpy(storage.clocks, game->clocks, sizeof(storage.clocks));
+  for (uint32_t i = 0; i < 2 * BANK_KEYS; ++i) persist_delete(watch_key() + i);
+  event_log_write(&game->events, 0, watch_key() + 1, EVENT_LOG_KEYS);
+  persist_write_data(watch_key(), &storage, sizeof(storage));
+}
+
+// Finished games are archived before a reset made on the watch, then read
+// back as the Past Games menu would
+static uint32_t archived;
+static uint32_t archive_bytes;
+static uint32_t archive_mismatches;
+
+static void archive_game() {
+  Archive archive;
+  archive_init(&archive, watch_key() + ARCHIVE_KEY);
+  uint32_t written = shim_stats.persist_bytes_written;
+  bool added;
+  PROFILE(OP_ARCHIVE, added = archive_add(&archive, &watch->game));
+  if (!added) return;
+  archived++;
+  archive_bytes += shim_stats.persist_bytes_written - written;
+  EventLog* events = &watch->game.events;
+  ArchiveReader* reader = archive_open(&archive, 0);
+  bool same = reader && archive_reader_count(reader) == event_log_size(events)
+      && archive_reader_summary(reader)->home == watch->game.home.total
+      && archive_reader_summary(reader)->away == watch->game.away.total;
+  for (uint16_t i = 0; same && i < event_log_size(events); ++i) {
+    Event event;
+    same = archive_reader_get(reader, i, &event) && event == event_log_get(events, i);
+  }
+  if (reader) archive_close(reader);
+  if (!same) archive_mismatches++;
+}
+
+// The app dies without reaching deinit(), only what was journaled survives
+static void app_kill() {
+  reply_clear(watch);
+  if (watch->sync.flush_timer) app_timer_cancel(watch->sync.flush_timer);
+  sync_stats_add(&watch->sync.stats);
+  memset(&watch->sync, 0, sizeof(watch->sync));
+  game_data_free(&watch->game);
+  memset(&watch->game, 0, sizeof(watch->game));
+}
+
+static void run_until(uint64_t target) {
+  while (shim_next_timer() <= target) {
+    PROFILE(OP_TIMER, shim_run_until(shim_next_timer()));
+  }
+  shim_run_until(target);
+}
+
+static void run_for(uint32_t seconds) {
+  run_until(shim_now_ms() + (uint64_t)seconds * 1000);
+}
+
+// Closed until the time is up or the worker opens the app
+static void away_for(uint32_t seconds) {
+  uint64_t target = shim_now_ms() + (uint64_t)seconds * 1000;
+  app_close();
+  while (shim_next_timer() <= target && shim_launch_reason != APP_LAUNCH_WORKER) {
+    PROFILE(OP_TIMER, shim_run_until(shim_next_timer()));
+  }
+  app_open();
+  run_for((uint32_t)((target - shim_now_ms()) / 1000));
+}
+
+// Button actions, following the handlers in main.c
+
+static TeamData* team(bool home) {
+  return home ? &watch->game.home : &watch->game.away;
+}
+
+static void press_down() {
+  GameData* game = &watch->game;
+  ClockId clock = game->shown;
+  if (game_data_clock_is_running(game, clock)) {
+    if (clock == CLOCK_PLAY && !game->post_snap && app_config.post_snap) {
+      game->post_snap = true;
+      game_data_clock_set_reset(game, clock, app_config.post_snap);
+      game_data_clock_reset(game, clock);
+      game_data_clock_start(game, clock);
+    } else {
+      game_data_clock_stop(game, clock);
+    }
+  } else {
+    if (clock == CLOCK_PLAY) {
+      game->post_snap = false;
+      game_data_clock_set_reset(game, clock, app_config.play_clock);
+      game_data_clock_reset(game, clock);
+    }
+    game_data_clock_start(game, clock);
+  }
+}
+
+static void change_clock(int index) {
+  ClockId clock = CLOCK_GAME;
+  int seconds = 0;
+  switch (index) {
+  case 0: break;
+  case 1: clock = CLOCK_PLAY; seconds = app_config.play_clock; break;
+  case 2: clock = CLOCK_BREAK; seconds = BREAK_CLOCK_SECONDS; break;
+  case 3: clock = CLOCK_BREAK; seconds = 60 * 20; break;
+  }
+  if (clock != CLOCK_GAME) {
+    if (clock == CLOCK_PLAY) watch->game.post_snap = false;
+    game_data_clock_set_reset(&watch->game, clock, seconds);
+    game_data_clock_reset(&watch->game, clock);
+  }
+  game_data_clock_show(&watch->game, clock);
+}
+
+
+// Whether two watches show the same game, down to the clocks' start times.
+// Which clock each one shows is up to its official.
+static bool same_game(GameData* a, GameData* b) {
+  TeamData* teams_a[2] = { &a->away, &a->home };
+  TeamData* teams_b[2] = { &b->away, &b->home };
+  for (int i = 0; i < 2; ++i) {
+    if (teams_a[i]->total != teams_b[i]->total || teams_a[i]->timeouts != teams_b[i]->timeouts
+        || memcmp(teams_a[i]->period_totals, teams_b[i]->period_totals, sizeof(teams_a[i]->period_totals))
+        || memcmp(teams_a[i]->half_totals, teams_b[i]->half_totals, sizeof(teams_a[i]->half_totals))) {
+      return false;
+    }
+  }
+  if (a->events.size != b->events.size
+      || memcmp(a->events.data, b->events.data, a->events.size * sizeof(Event))) {
+    return false;
+  }
+  for (int i = 0; i < CLOCK_COUNT; ++i) {
+    if (a->clocks[i].running != b->clocks[i].running || a->clocks[i].reset_to != b->clocks[i].reset_to
+        || game_data_clock_get_value(a, i) != game_data_clock_get_value(b, i)) {
+      return false;
+    }
+  }
+  return a->quarter == b->quarter && a->try_active == b->try_active
+      && a->home_team_active == b->home_team_active;
+}
+
+// What a script command printed, kept until the next command so that the
+// expect lines after it can check it
+#define REPORTS_MAX 8
+#define REPORT_LENGTH 128
+static char reports[REPORTS_MAX][REPORT_LENGTH];
+static uint8_t report_count;
+static uint8_t report_next;
+
+static void report(const char* file, int number, const char* format, ...) {
+  char text[REPORT_LENGTH];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(text, sizeof(text), format, args);
+  va_end(args);
+  printf("%s:%d: %s\n", file, number, text);
+  if (report_count < REPORTS_MAX) memcpy(reports[report_count++], text, sizeof(text));
+}
+
+static bool expect(const char* text, const char* file, int number) {
+  if (report_next >= report_count) {
+    printf("%s:%d: expected '%s', nothing printed\n", file, number, text);
+    return false;
+  }
+  const char* got = reports[report_next++];
+  if (strcmp(got, text) == 0) return true;
+  printf("%s:%d: expected '%s', got '%s'\n", file, number, text, got);
+  return false;
+}
+
+static void game_text(char* out, size_t size, GameData* game) {
+  static const char* names[CLOCK_COUNT] = { "clock", "play clock", "break clock" };
+  int used = snprintf(out, size, "away %u home %u, quarter %u, timeouts %u/%u", game->away.total,
+                      game->home.total, game->quarter + 1, game->away.timeouts, game->home.timeouts);
+  // The game clock, and whichever other clock is shown
+  for (int i = 0; i < CLOCK_COUNT && used < (int)size; ++i) {
+    if (i != CLOCK_GAME && i != game->shown) continue;
+    uint16_t seconds = game_data_clock_get_seconds(game, i);
+    used += snprintf(out + used, size - used, ", %s %02u:%02u%s", names[i], seconds / 60, seconds % 60,
+                     game_data_clock_is_running(game, i) ? " running" : "");
+  }
+}
+
+static void print_game(const char* prefix, GameData* game) {
+  char text[REPORT_LENGTH];
+  game_text(text, sizeof(text), game);
+  printf("%s: %s\n", prefix, text);
+}
+
+static void check_sync(const char* file, int number) {
+  if (watch_count < 2) return;
+  // Tails are repeated for three and a half minutes, allow for all of them
+  for (int i = 0; i < 300 && !radio_idle(); ++i) run_for(1);
+  sync_checks++;
+  for (uint8_t i = 1; i < watch_count; ++i) {
+    if (same_game(&watches[0].game, &watches[i].game)) continue;
+    sync_diverged++;
+    printf("%s:%d: watch %u differs from watch 0\n", file, number, i);
+    print_game("  watch 0", &watches[0].game);
+    print_game("  other  ", &watches[i].game);
+  }
+}
+
+// Wrist movement from a file, starting now and handed to the detector a batch
+// at a time as the accelerometer service would. A part batch at the end is
+// never delivered.
+static bool replay_accel(const char* name, const char* file, int number) {
+  char path[256];
+  const char* slash = strrchr(file, '/');
+  snprintf(path, sizeof(path), "%.*s%s", slash ? (int)(slash - file + 1) : 0, file, name);
+  FILE* samples = fopen(path, "r");
+  if (!samples) {
+    perror(path);
+    return false;
+  }
+  TapDetector detector;
+  tap_detector_init(&detector);
+  AccelData batch[TAP_BATCH];
+  uint32_t count = 0;
+  uint32_t taken = 0;
+  uint64_t start = shim_now_ms();
+  char line[64];
+  while (fgets(line, sizeof(line), samples)) {
+    char* comment = strchr(line, '#');
+    if (comment) *comment = '\0';
+    int x, y, z;
+    char vibrating = 0;
+    int fields = sscanf(line, "%d %d %d %c", &x, &y, &z, &vibrating);
+    if (fields < 3) continue;
+    batch[count++] = (AccelData) {
+      .x = x, .y = y, .z = z, .did_vibrate = fields == 4 && vibrating == 'v',
+      .timestamp = start + (uint64_t)taken++ * 1000 / TAP_SAMPLING_HZ
+    };
+    if (count < TAP_BATCH) continue;
+    count = 0;
+    run_until(batch[TAP_BATCH - 1].timestamp);
+    uint8_t taps;
+    PROFILE(OP_TAPS, taps = tap_detector_feed(&detector, batch, TAP_BATCH));
+    // As accel_batch in main.c, which only listens on the play clock
+    if (!taps || !app_config.tap_control || watch->game.shown != CLOCK_PLAY) continue;
+    press_down();
+    uint32_t ms = (uint32_t)(shim_now_ms() - start);
+    report(file, number, "double tap by %u.%02us, play clock %s", ms / 1000, ms % 1000 / 10,
+           game_data_clock_is_running(&watch->game, CLOCK_PLAY) ? "running" : "stopped");
+  }
+  fclose(samples);
+  return true;
+}
+
+// Config messages, packed as the watch receives them with the message key
+// of each field as its index
+
+static const char* config_fields[] = {
+  NULL, "game", "play", "timeouts", "periods", "postsnap", "reset", NULL, NULL, NULL, NULL,
+  "gamewarning", "playwarning", "breakwarning", NULL, "up2", "up3", "select2", "select3", "tap"
+};
+
+static void config_message(char* field, char* value, const char* file, int number) {
+  uint8_t buffer[128];
+  uint16_t size = 0;
+  while (field && value && size + sizeof(Tuple) + sizeof(int32_t) <= sizeof(buffer)) {
+    for (uint32_t key = 1; key < sizeof(config_fields) / sizeof(config_fields[0]); ++key) {
+      if (!config_fields[key] || strcmp(field, config_fields[key]) != 0) continue;
+      Tuple* t = (Tuple*)(buffer + size);
+      t->key = key;
+      t->type = TUPLE_INT;
+      t->length = sizeof(int32_t);
+      t->value->int32 = atoi(value);
+      size += sizeof(Tuple) + t->length;
+    }
+    field = strtok(NULL, " \t\r\n");
+    value = strtok(NULL, " \t\r\n");
+  }
+  DictionaryIterator iterator;
+  dict_read_begin_from_buffer(&iterator, buffer, size);
+  AppConfigResult result;
+  PROFILE(OP_CONFIG, result = app_config_reload(&iterator));
+  char text[REPORT_LENGTH] = "config";
+  for (uint32_t key = 1; key < sizeof(config_fields) / sizeof(config_fields[0]); ++key) {
+    size_t used = strlen(text);
+    if (result.accepted & 1ul << key) snprintf(text + used, sizeof(text) - used, " %s", config_fields[key]);
+    if (result.rejected & 1ul << key) snprintf(text + used, sizeof(text) - used, " !%s", config_fields[key]);
+  }
+  report(file, number, "%s%s", text, result.changed ? ", changed" : ", unchanged");
+  watch->reply_waiting = true;
+  send_reply(watch);
+  if (result.reset) {
+    archive_game();
+    PROFILE(OP_NEWGAME, game_data_reset(&watch->game));
+    heap_stats_reset();
+  }
+}
+
+// Script parsing
+
+static int parse_team(const char* word) {
+  if (!word) return -1;
+  if (strcmp(word, "home") == 0) return 1;
+  if (strcmp(word, "away") == 0) return 0;
+  return -1;
+}
+
+static bool run_line(char* line, const char* file, int number) {
+  char* comment = strchr(line, '#');
+  if (comment) *comment = '\0';
+  // The rest of an expect line is the text, spaces and all
+  char* start = line + strspn(line, " \t");
+  if (strncmp(start, "expect ", 7) == 0) {
+    char* text = start + 7;
+    text[strcspn(text, "\r\n")] = '\0';
+    for (size_t end = strlen(text); end > 0 && (text[end - 1] == ' ' || text[end - 1] == '\t'); --end) {
+      text[end - 1] = '\0';
+    }
+    return expect(text, file, number);
+  }
+  char* command = strtok(line, " \t\r\n");
+  if (!command) return true;
+  report_count = 0;
+  report_next = 0;
+  char* arg1 = strtok(NULL, " \t\r\n");
+  char* arg2 = strtok(NULL, " \t\r\n");
+  int home = parse_team(arg1);
+
+  if (strcmp(command, "watch") == 0 && arg1) {
+    int index = atoi(arg1);
+    if (index < 0 || index >= watch_count) goto error;
+    watch = &watches[index];
+  } else if (strcmp(command, "wait") == 0 && arg1) {
+    run_for(atoi(arg1));
+  } else if (strcmp(command, "down") == 0) {
+    PROFILE(OP_DOWN, press_down());
+  } else if (strcmp(command, "reset") == 0) {
+    PROFILE(OP_RESET, game_data_clock_reset(&watch->game, watch->game.shown));
+  } else if (strcmp(command, "quarter") == 0) {
+    PROFILE(OP_QUARTER, game_data_end_quarter(&watch->game));
+  } else if (strcmp(command, "clock") == 0 && arg1) {
+    static const char* clocks[] = {"game", "play", "timeout", "half"};
+    int index = -1;
+    for (int i = 0; i < 4; ++i) if (strcmp(arg1, clocks[i]) == 0) index = i;
+    if (index < 0) goto error;
+    PROFILE(OP_CLOCK, change_clock(index));
+  } else if (strcmp(command, "score") == 0 && home >= 0 && arg2) {
+    uint8_t points;
+    if (strcmp(arg2, "td") == 0) points = 6;
+    else if (strcmp(arg2, "fg") == 0) points = 3;
+    else if (strcmp(arg2, "safety") == 0) points = 2;
+    else goto error;
+    PROFILE(OP_SCORE, game_data_add_score(&watch->game, home, points));
+  } else if (strcmp(command, "try") == 0 && arg1) {
+    PROFILE(OP_TRY, game_data_add_try(&watch->game, atoi(arg1)));
+  } else if (strcmp(command, "penalty") == 0 && home >= 0 && arg2) {
+    PROFILE(OP_PENALTY, game_data_add_penalty(&watch->game, home, atoi(arg2)));
+  } else if (strcmp(command, "timeout") == 0 && home >= 0) {
+    bool taken = false;
+    PROFILE(OP_TIMEOUT, taken = game_data_add_timeout(&watch->game, home));
+    if (!taken) report(file, number, "timeout %s not taken", arg1);
+  } else if (strcmp(command, "undo") == 0) {
+    PROFILE(OP_UNDO, game_data_undo(&watch->game));
+  } else if (strcmp(command, "accel") == 0 && arg1) {
+    if (!replay_accel(arg1, file, number)) goto error;
+  } else if (strcmp(command, "chord") == 0 && arg1 && arg2) {
+    // A double or triple click of up or select on the main window
+    Chord chord;
+    if (strcmp(arg1, "up") == 0) chord = CHORD_UP_DOUBLE;
+    else if (strcmp(arg1, "select") == 0) chord = CHORD_SELECT_DOUBLE;
+    else goto error;
+    if (atoi(arg2) == 3) chord++;
+    else if (atoi(arg2) != 2) goto error;
+    bool taken = false;
+    PROFILE(OP_SHORTCUT, taken = game_data_shortcut(&watch->game, app_config.shortcuts[chord]));
+    if (!taken) report(file, number, "chord %s %s not taken", arg1, arg2);
+  } else if (strcmp(command, "relaunch") == 0) {
+    app_close();
+    app_open();
+  } else if (strcmp(command, "away") == 0 && arg1) {
+    away_for(atoi(arg1));
+  } else if (strcmp(command, "damage") == 0) {
+    damage_snapshot();
+  } else if (strcmp(command, "oldsave") == 0) {
+    save_v9();
+  } else if (strcmp(command, "kill") == 0) {
+    app_kill();
+    app_open();
+  } else if (strcmp(command, "show") == 0) {
+    char text[REPORT_LENGTH];
+    game_text(text, sizeof(text), &watch->game);
+    report(file, number, "%s", text);
+    printf("  by quarter");
+    for (int i = 0; i <= PERIODS_MAX; ++i) {
+      printf(" %u-%u", watch->game.away.period_totals[i], watch->game.home.period_totals[i]);
+    }
+    printf(", halves %u-%u %u-%u\n", watch->game.away.half_totals[0], watch->game.home.half_totals[0],
+           watch->game.away.half_totals[1], watch->game.home.half_totals[1]);
+  } else if (strcmp(command, "counts") == 0) {
+    report(file, number, "warnings %u, expiries %u", warnings, expiries);
+  } else if (strcmp(command, "outbox") == 0 && arg1 && strcmp(arg1, "fail") == 0 && arg2) {
+    watch->outbox_refusals = atoi(arg2);
+  } else if (strcmp(command, "check") == 0) {
+    check_sync(file, number);
+  } else if (strcmp(command, "config") == 0) {
+    config_message(arg1, arg2, file, number);
+  } else if (strcmp(command, "newgame") == 0) {
+    archive_game();
+    PROFILE(OP_NEWGAME, game_data_reset(&watch->game));
+    heap_stats_reset();
+  } else {
+    goto error;
+  }
+  return true;
+error:
+  fprintf(stderr, "%s:%d: cannot parse command '%s'\n", file, number, command);
+  return false;
+}
+
+static bool run_script(const char* path) {
+  FILE* file = fopen(path, "r");
+  if (!file) {
+    perror(path);
+    return false;
+  }
+  char line[256];
+  int number = 0;
+  bool ok = true;
+  while (ok && fgets(line, sizeof(line), file)) {
+    ok = run_line(line, path, ++number);
+  }
+  fclose(file);
+  return ok;
+}
+
+// Generated games, a deterministic mix of plays and stoppages
+
+static uint32_t rng_state;
+
+static uint32_t rng() {
+  return xorshift(&rng_state);
+}
+
+static uint32_t rng_range(uint32_t low, uint32_t high) {
+  return low + rng() % (high - low + 1);
+}
+
+static void command(const char* format, ...) __attribute__((format(printf, 1, 2)));
+static void command(const char* format, ...) {
+  char line[64];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(line, sizeof(line), format, args);
+  va_end(args);
+  if (verbose) printf("  %s\n", line);
+  run_line(line, "generated", 0);
+}
+
+static void generate_quarter() {
+  command("clock game");
+  while (game_data_clock_get_value(&watch->game, CLOCK_GAME) > 0) {
+    // Game clock runs from the snap. After a third of plays it is left
+    // running on through the next play clock.
+    if (!game_data_clock_is_running(&watch->game, CLOCK_GAME)) command("down");
+    command("wait %u", rng_range(5, 40));
+    if (game_data_clock_is_running(&watch->game, CLOCK_GAME) && rng_range(0, 2) != 0) command("down");
+
+    const char* side = rng() & 1 ? "home" : "away";
+    uint32_t roll = rng_range(0, 99);
+    if (roll < 6) {
+      command("score %s td", side);
+      command("wait %u", rng_range(20, 60));
+      command("try %u", rng_range(0, 9) < 8 ? 1 : rng_range(0, 2));
+    } else if (roll < 10) {
+      command("score %s fg", side);
+    } else if (roll < 11) {
+      command("score %s safety", side);
+    } else if (roll < 26) {
+      command("penalty %s %u", side, rng_range(1, 99));
+    } else if (roll < 29 && team(side[0] == 'h')->timeouts > 0) {
+      command("timeout %s", side);
+    } else if (roll < 31) {
+      // A mis-keyed entry, corrected straight away
+      command("penalty %s %u", side, rng_range(1, 99));
+      command("undo");
+    }
+    // Ready for play, the play clock runs until the snap
+    command("clock play");
+    command("down");
+    command("wait %u", rng_range(5, 24));
+    if (game_data_clock_is_running(&watch->game, CLOCK_PLAY)) command("down");
+    command("clock game");
+  }
+  command("quarter");
+}
+
+static void generate_game() {
+  for (uint8_t quarter = 0; quarter < app_config.periods; ++quarter) {
+    generate_quarter();
+    if (quarter + 1 == app_config.periods / 2) {
+      command("clock half");
+      command("down");
+      command("away 1200");
+    }
+    // Officials commonly leave the app between quarters, and sometimes
+    // the watch gives up on it mid-game
+    if (watch_count > 1) command("watch %u", rng_range(0, watch_count - 1));
+    command(rng_range(0, 9) == 0 ? "kill" : "relaunch");
+    if (watch_count > 1) command("watch 0");
+  }
+  command("check");
+  command("newgame");
+}
+
+// Reporting
+
+static void print_report(uint32_t games, uint64_t wall_ns) {
+  double sim_minutes = shim_now_ms() / 60000.0;
+  double wall_ms = wall_ns / 1e6;
+  printf("games                %u\n", games);
+  printf("simulated time       %.1f min (%.0fx real time)\n", sim_minutes,
+         wall_ms > 0 ? shim_now_ms() / wall_ms : 0);
+  printf("wakeups              %u (%.1f per simulated minute)\n", shim_stats.wakeups,
+         sim_minutes > 0 ? shim_stats.wakeups / sim_minutes : 0);
+  printf("  ticks              %u, %u changed the display\n", ticks, display_changes);
+
+  printf("  warnings           %u\n", warnings);
+  printf("  expiries           %u\n", expiries);
+  printf("timers registered    %u (%u cancelled)\n", shim_stats.timers_registered,
+         shim_stats.timers_cancelled);
+  printf("persist writes       %u (%u bytes)\n", shim_stats.persist_writes,
+         shim_stats.persist_bytes_written);
+  printf("activity counters    %u wakeups, %u flash writes, busiest of the last %u minutes %u and %u\n",
+         activity.totals[ACTIVITY_WAKEUP], activity.totals[ACTIVITY_FLASH], ACTIVITY_MINUTES,
+         activity_peak(ACTIVITY_WAKEUP), activity_peak(ACTIVITY_FLASH));
+  printf("persist reads        %u (%u bytes), %u lookups\n", shim_stats.persist_reads,
+         shim_stats.persist_bytes_read, shim_stats.persist_lookups);
+  printf("archive              %u games (%.0f bytes each), %u read back wrong\n", archived,
+         archived ? (double)archive_bytes / archived : 0, archive_mismatches);
+  printf("heap                 %zu bytes peak, %u allocations\n", shim_stats.heap_peak,
+         shim_stats.allocations);
+  printf("heap stats           %u bytes peak, %u bytes free at the lowest\n", heap_stats.used_peak,
+         heap_stats.free_low);
+  printf("worker               %u starts, %u messages, %u launches, %u alerts\n", shim_stats.worker_starts,
+         shim_stats.worker_messages, shim_stats.worker_launches, worker_alerts);
+  if (watch_count > 1) {
+    printf("sync frames          %u sent (%u bytes, %.1f per game), %u received\n",
+           sync_totals.frames_sent, sync_totals.bytes_sent,
+           (double)sync_totals.frames_sent / games, sync_totals.frames_received);
+    printf("  records applied    %u, %u duplicate frames\n", sync_totals.records_applied,
+           sync_totals.duplicates);
+    printf("  repairs            %u resend requests, %u frames resent, %u whole-game resyncs\n",
+           sync_totals.resend_requests, sync_totals.frames_resent, sync_totals.resyncs_sent);
+    printf("radio                %u delivered, %u lost\n", frames_delivered, frames_dropped);
+    printf("sync checks          %u, %u diverged\n", sync_checks, sync_diverged);
+  }
+  if (replies_sent || replies_dropped) {
+    printf("config replies       %u sent, %u dropped\n", replies_sent, replies_dropped);
+  }
+#ifdef REFWATCH_TRACE
+  // The ring only holds the end of the run, as a dump to the phone would
+  static const char* trace_names[TRACE_EVENT_COUNT] = {
+    "deadline", "draw static", "draw score", "draw choice", "game read", "game write", "click", "menu",
+    "frame"
+  };
+  uint32_t traced[TRACE_EVENT_COUNT] = { 0 };
+  TraceRecord record;
+  for (uint16_t i = 0; trace_read(i, &record, 1); ++i) {
+    if (record.end && record.event < TRACE_EVENT_COUNT) traced[record.event]++;
+  }
+  printf("trace                %u records,", trace_count());
+  for (int i = 0; i < TRACE_EVENT_COUNT; ++i) {
+    if (traced[i]) printf(" %s %u", trace_names[i], traced[i]);
+  }
+  printf("\n");
+#endif
+  printf("\n%-18s %8s %10s %10s\n", "cpu per call", "calls", "mean ns", "max ns");
+  for (int i = 0; i < OP_COUNT; ++i) {
+    if (!profiles[i].calls) continue;
+    printf("%-18s %8u %10llu %10llu\n", op_names[i], profiles[i].calls,
+           (unsigned long long)(profiles[i].total_ns / profiles[i].calls),
+           (unsigned long long)profiles[i].max_ns);
+  }
+}
+
+int main(int argc, char** argv) {
+  uint32_t games = 1;
+  rng_state = 1;
+  int arg = 1;
+  for (; arg < argc && argv[arg][0] == '-'; ++arg) {
+    if (strcmp(argv[arg], "-g") == 0 && arg + 1 < argc) games = atoi(argv[++arg]);
+    else if (strcmp(argv[arg], "-s") == 0 && arg + 1 < argc) rng_state = atoi(argv[++arg]) | 1;
+    else if (strcmp(argv[arg], "-w") == 0 && arg + 1 < argc) watch_count = atoi(argv[++arg]);
+    else if (strcmp(argv[arg], "-l") == 0 && arg + 1 < argc) latency_ms = atoi(argv[++arg]);
+    else if (strcmp(argv[arg], "-d") == 0 && arg + 1 < argc) drop_percent = atoi(argv[++arg]);
+    else if (strcmp(argv[arg], "-v") == 0) verbose = true;
+    else {
+      fprintf(stderr, "usage: %s [-g games] [-s seed] [-w watches] [-l latency] [-d drop] [-v] [script...]\n",
+              argv[0]);
+      return 2;
+    }
+  }
+
+  if (watch_count < 1 || watch_count > WATCHES_MAX) {
+    fprintf(stderr, "%s: between 1 and %d watches\n", argv[0], WATCHES_MAX);
+    return 2;
+  }
+
+  shim_reset(SIM_EPOCH);
+  shim_persist_clear();
+  shim_worker_start = worker_start;
+  shim_worker_stop = worker_stop;
+  for (int i = watch_count - 1; i >= 0; --i) {
+    watch = &watches[i];
+    app_open();
+  }
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  bool ok = true;
+  if (arg < argc) {
+    games = argc - arg;
+    for (; ok && arg < argc; ++arg) ok = run_script(argv[arg]);
+  } else {
+    for (uint32_t i = 0; i < games; ++i) generate_game();
+  }
+  for (watch = watches; watch < watches + watch_count; ++watch) app_close();
+  watch = &watches[0];
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  print_report(games, (uint64_t)(end.tv_sec - start.tv_sec) * 1000000000ull
+               + end.tv_nsec - start.tv_nsec);
+  return ok && !sync_diverged && !archive_mismatches ? 0 : 1;
+}
@@ -0,0 +1,53 @@
+#include <pebble.h>
+#include "Activity.h"
+
+Activity activity;
+
+static uint32_t activity_now() {
+  time_t seconds;
+  uint16_t milliseconds;
+  time_ms(&seconds, &milliseconds);
+  return (uint32_t)seconds / 60;
+}
+
+// Moves the newest bucket on to the current minute, clearing the minutes
+// nothing was counted in
+static void activity_roll(uint32_t minute) {
+  if (activity.filled && minute == activity.minute) return;
+  uint32_t gap = minute - activity.minute;
+  // First count, or the wall clock moved backwards or a long way on
+  if (!activity.filled || minute < activity.minute || gap > ACTIVITY_MINUTES) {
+    memset(activity.minutes, 0, sizeof(activity.minutes));
+    activity.filled = activity.filled && minute > activity.minute ? ACTIVITY_MINUTES : 1;
+    activity.minute = minute;
+    return;
+  }
+  while (activity.minute != minute) {
+    ++activity.minute;
+    memset(&activity.minutes[activity.minute % ACTIVITY_MINUTES], 0, sizeof(ActivityMinute));
+    if (activity.filled < ACTIVITY_MINUTES) ++activity.filled;
+  }
+}
+
+void activity_count(ActivityKind kind) {
+  activity_roll(activity_now());
+  uint16_t* count = &activity.minutes[activity.minute % ACTIVITY_MINUTES].counts[kind];
+  if (*count < UINT16_MAX) ++*count;
+  ++activity.totals[kind];
+}
+
+uint16_t activity_minute(ActivityKind kind, uint8_t ago) {
+  activity_roll(activity_now());
+  if (ago >= activity.filled) return 0;
+  return activity.minutes[(activity.minute - ago) % ACTIVITY_MINUTES].counts[kind];
+}
+
+uint16_t activity_peak(ActivityKind kind) {
+  activity_roll(activity_now());
+  uint16_t peak = 0;
+  for (uint8_t i = 0; i < activity.filled; ++i) {
+    uint16_t count = activity.minutes[(activity.minute - i) % ACTIVITY_MINUTES].counts[kind];
+    if (count > peak) peak = count;
+  }
+  return peak;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <pebble.h>
+
+// Always-on counters of the things that cost battery, kept in one bucket
+// per minute for the last ACTIVITY_MINUTES minutes, plus totals since the
+// app was launched. Counting is an increment and a minute check.
+typedef enum {
+  ACTIVITY_WAKEUP,    // An app timer fired
+  ACTIVITY_REDRAW,    // A layer update proc ran
+  ACTIVITY_DIRTY,     // A layer was marked dirty or given new text
+  ACTIVITY_VIBE,
+  ACTIVITY_FLASH,     // A persist write or delete
+  ACTIVITY_SENT,      // An AppMessage went out
+  ACTIVITY_RECEIVED,  // An AppMessage came in
+  ACTIVITY_ACCEL,     // A batch of accelerometer samples for tap control
+  ACTIVITY_KIND_COUNT
+} ActivityKind;
+
+#define ACTIVITY_MINUTES 16
+
+typedef struct ActivityMinute_t {
+  uint16_t counts[ACTIVITY_KIND_COUNT];
+} ActivityMinute;
+
+typedef struct Activity_t {
+  ActivityMinute minutes[ACTIVITY_MINUTES];
+  // Minutes since the epoch of the newest bucket, which is
+  // minutes[minute % ACTIVITY_MINUTES]
+  uint32_t minute;
+  // Buckets that have been counted into, 0 before the first count
+  uint8_t filled;
+  uint32_t totals[ACTIVITY_KIND_COUNT];
+} Activity;
+
+extern Activity activity;
+
+void activity_count(ActivityKind kind);
+// The count ago minutes before the current minute, 0 for the current one
+uint16_t activity_minute(ActivityKind kind, uint8_t ago);
+// Busiest minute still held
+uint16_t activity_peak(ActivityKind kind);
@@ -1,11 +1,56 @@
 #include <pebble.h>
 #include "AppConfig.h"
+#include "EventLog.h"
+#include "Activity.h"
 
-#define CONFIG_VERSION 1
+#define CONFIG_VERSION 4
 #define CONFIG_KEY 100
+
+// Two minute digits on the clock
+#define GAME_CLOCK_MAX (99 * 60 + 59)
+// As many as the score panel has room for
+#define TIMEOUTS_MAX 3
+#define POST_SNAP_MAX 60
   
 AppConfig app_config;
 
+// Versions 2 and 3 are the start of the current one, missing the fields
+// added since
+typedef struct AppConfigV3_t {
+  uint16_t version;
+  uint16_t game_clock;
+  uint8_t play_clock;
+  uint8_t timeouts;
+  uint8_t periods;
+  uint8_t post_snap;
+  uint16_t game_warning;
+  uint8_t play_warning;
+  uint8_t break_warning;
+  uint8_t shortcuts[CHORD_COUNT];
+} AppConfigV3;
+
+typedef struct AppConfigV2_t {
+  uint16_t version;
+  uint16_t game_clock;
+  uint8_t play_clock;
+  uint8_t timeouts;
+  uint8_t periods;
+  uint8_t post_snap;
+  uint16_t game_warning;
+  uint8_t play_warning;
+  uint8_t break_warning;
+} AppConfigV2;
+
+// Version 1 had no warnings
+typedef struct AppConfigV1_t {
+  uint16_t version;
+  uint16_t game_clock;
+  uint8_t play_clock;
+  uint8_t timeouts;
+  uint8_t periods;
+  uint8_t post_snap;
+} AppConfigV1;
+
 static void app_config_default() {
   app_config.version = CONFIG_VERSION;
   app_config.game_clock = 15 * 60;
@@ -13,13 +58,76 @@ static void app_config_default() {
   app_config.timeouts = 3;
   app_config.periods = 4;
   app_config.post_snap = 0;
+  app_config.game_warning = 2 * 60;
+  app_config.play_warning = 10;
+  app_config.break_warning = 0;
+  memset(app_config.shortcuts, SHORTCUT_NONE, sizeof(app_config.shortcuts));
+  app_config.tap_control = false;
+}
+
+static bool shortcuts_valid(const uint8_t* shortcuts) {
+  for (uint8_t chord = 0; chord < CHORD_COUNT; ++chord) {
+    if (shortcuts[chord] >= SHORTCUT_COUNT) return false;
+  }
+  return true;
+}
+
+static bool app_config_valid(const AppConfig* config) {
+  return config->version == CONFIG_VERSION
+      && config->game_clock >= 1 && config->game_clock <= GAME_CLOCK_MAX
+      && config->play_clock >= 1 && config->play_clock <= config->game_clock
+      && config->timeouts <= TIMEOUTS_MAX
+      && config->periods >= 2 && config->periods <= PERIODS_MAX && config->periods % 2 == 0
+      && config->post_snap <= POST_SNAP_MAX
+      && config->game_warning < config->game_clock && config->play_warning < config->play_clock
+      && config->break_warning < BREAK_CLOCK_SECONDS
+      && shortcuts_valid(config->shortcuts);
+}
+
+// Field by field, as padding between them is not kept by assignment and
+// would otherwise cost a flash write for a config that has not changed
+static bool app_config_equal(const AppConfig* a, const AppConfig* b) {
+  return a->version == b->version && a->game_clock == b->game_clock && a->play_clock == b->play_clock
+      && a->timeouts == b->timeouts && a->periods == b->periods && a->post_snap == b->post_snap
+      && a->game_warning == b->game_warning && a->play_warning == b->play_warning
+      && a->break_warning == b->break_warning
+      && memcmp(a->shortcuts, b->shortcuts, sizeof(a->shortcuts)) == 0
+      && a->tap_control == b->tap_control;
 }
 
 void app_config_init() {
   if (persist_exists(CONFIG_KEY))
   {
-    if (persist_read_data(CONFIG_KEY, &app_config, sizeof(AppConfig)) == sizeof(AppConfig)) {
-      return;
+    union {
+      AppConfig current;
+      AppConfigV3 v3;
+      AppConfigV2 v2;
+      AppConfigV1 v1;
+    } buffer;
+    int size = persist_read_data(CONFIG_KEY, &buffer, sizeof(buffer));
+    if (size == sizeof(AppConfigV1) && buffer.v1.version == 1) {
+      app_config_default();
+      app_config.game_clock = buffer.v1.game_clock;
+      app_config.play_clock = buffer.v1.play_clock;
+      app_config.timeouts = buffer.v1.timeouts;
+      app_config.periods = buffer.v1.periods;
+      app_config.post_snap = buffer.v1.post_snap;
+      // Warnings that would fall before the clock starts are left off
+      if (app_config.game_warning >= app_config.game_clock) app_config.game_warning = 0;
+      if (app_config.play_warning >= app_config.play_clock) app_config.play_warning = 0;
+      if (app_config_valid(&app_config)) return;
+    } else if ((size == sizeof(AppConfigV2) && buffer.v2.version == 2)
+               || (size == sizeof(AppConfigV3) && buffer.v3.version == 3)) {
+      app_config_default();
+      memcpy(&app_config, &buffer, size);
+      app_config.version = CONFIG_VERSION;
+      // Break warnings were once taken up to 255, which never fired
+      if (app_config.break_warning >= BREAK_CLOCK_SECONDS) app_config.break_warning = 0;
+      if (app_config_valid(&app_config)) return;
+    } else if (size == sizeof(AppConfig)) {
+      app_config = buffer.current;
+      if (app_config.break_warning >= BREAK_CLOCK_SECONDS) app_config.break_warning = 0;
+      if (app_config_valid(&app_config)) return;
     }
   }
   app_config_default();
@@ -31,23 +139,147 @@ void app_config_init() {
 #define PERIODS 4
 #define POST_SNAP 5
 #define RESET 6
+#define GAME_WARNING 11
+#define PLAY_WARNING 12
+#define BREAK_WARNING 13
+// One key per Chord, in order
+#define SHORTCUT_UP_DOUBLE 15
+#define SHORTCUT_UP_TRIPLE 16
+#define SHORTCUT_SELECT_DOUBLE 17
+#define SHORTCUT_SELECT_TRIPLE 18
+#define TAP_CONTROL 19
+
+// The phone may send any width of integer, false for anything else or a
+// value outside low to high
+static bool tuple_read(const Tuple* t, int32_t low, int32_t high, int32_t* value) {
+  if (t->type == TUPLE_INT) {
+    switch (t->length) {
+    case 1: *value = t->value->int8; break;
+    case 2: *value = t->value->int16; break;
+    case 4: *value = t->value->int32; break;
+    default: return false;
+    }
+  } else if (t->type == TUPLE_UINT) {
+    switch (t->length) {
+    case 1: *value = t->value->uint8; break;
+    case 2: *value = t->value->uint16; break;
+    case 4:
+      if (t->value->uint32 > INT32_MAX) return false;
+      *value = t->value->uint32;
+      break;
+    default: return false;
+    }
+  } else {
+    return false;
+  }
+  return *value >= low && *value <= high;
+}
+
+// Undo a field taken from the message, keeping the stored value
+static void app_config_reject(AppConfigResult* result, uint8_t key) {
+  result->accepted &= ~(1ul << key);
+  result->rejected |= 1ul << key;
+}
 
-bool app_config_reload(DictionaryIterator* iterator) {
+AppConfigResult app_config_reload(DictionaryIterator* iterator) {
   APP_LOG(APP_LOG_LEVEL_DEBUG, "Starting reload");
-  bool reset = false;
+  AppConfigResult result = { 0 };
+  AppConfig staged = app_config;
+  int32_t value;
+  bool valid;
   Tuple* t = dict_read_first(iterator);
   while (t != NULL) {
     switch(t->key) {
-    case GAME_CLOCK: app_config.game_clock = t->value->uint16; break;
-    case PLAY_CLOCK: app_config.play_clock = t->value->uint8; break;
-    case TIMEOUTS: app_config.timeouts = t->value->uint8; break;
-    case PERIODS: app_config.periods = t->value->uint8; break;
-    case POST_SNAP: app_config.post_snap = t->value->uint8; break;
-    case RESET: reset = true; break;
-    default: break;
+    case GAME_CLOCK:
+      if ((valid = tuple_read(t, 1, GAME_CLOCK_MAX, &value))) staged.game_clock = value;
+      break;
+    case PLAY_CLOCK:
+      if ((valid = tuple_read(t, 1, UINT8_MAX, &value))) staged.play_clock = value;
+      break;
+    case TIMEOUTS:
+      if ((valid = tuple_read(t, 0, TIMEOUTS_MAX, &value))) staged.timeouts = value;
+      break;
+    case PERIODS:
+      // Halves are split at periods / 2
+      if ((valid = tuple_read(t, 2, PERIODS_MAX, &value) && value % 2 == 0)) staged.periods = value;
+      break;
+    case POST_SNAP:
+      if ((valid = tuple_read(t, 0, POST_SNAP_MAX, &value))) staged.post_snap = value;
+      break;
+    case GAME_WARNING:
+      if ((valid = tuple_read(t, 0, GAME_CLOCK_MAX, &value))) staged.game_warning = value;
+      break;
+    case PLAY_WARNING:
+      if ((valid = tuple_read(t, 0, UINT8_MAX, &value))) staged.play_warning = value;
+      break;
+    case BREAK_WARNING:
+      if ((valid = tuple_read(t, 0, BREAK_CLOCK_SECONDS - 1, &value))) staged.break_warning = value;
+      break;
+    case SHORTCUT_UP_DOUBLE:
+    case SHORTCUT_UP_TRIPLE:
+    case SHORTCUT_SELECT_DOUBLE:
+    case SHORTCUT_SELECT_TRIPLE:
+      if ((valid = tuple_read(t, SHORTCUT_NONE, SHORTCUT_COUNT - 1, &value))) {
+        staged.shortcuts[t->key - SHORTCUT_UP_DOUBLE] = value;
+      }
+      break;
+    case TAP_CONTROL:
+      if ((valid = tuple_read(t, 0, 1, &value))) staged.tap_control = value;
+      break;
+    case RESET:
+      result.reset = true;
+      valid = true;
+      break;
+    default:
+      t = dict_read_next(iterator);
+      continue;
     }
+    if (valid) result.accepted |= 1ul << t->key;
+    else result.rejected |= 1ul << t->key;
     t = dict_read_next(iterator);
   }
-  persist_write_data(CONFIG_KEY, &app_config, sizeof(AppConfig));
-  return reset;
-}
\ No newline at end of file
+  // The play clock has to fit in the game clock. The stored config already
+  // does, so going back to it a field at a time always ends up valid.
+  if (staged.play_clock > staged.game_clock && (result.accepted & 1 << PLAY_CLOCK)) {
+    staged.play_clock = app_config.play_clock;
+    app_config_reject(&result, PLAY_CLOCK);
+  }
+  if (staged.play_clock > staged.game_clock) {
+    staged.game_clock = app_config.game_clock;
+    app_config_reject(&result, GAME_CLOCK);
+  }
+  // Likewise a warning has to come after its clock starts
+  if (staged.game_warning >= staged.game_clock && (result.accepted & 1 << GAME_WARNING)) {
+    staged.game_warning = app_config.game_warning;
+    app_config_reject(&result, GAME_WARNING);
+  }
+  if (staged.game_warning >= staged.game_clock) {
+    staged.game_clock = app_config.game_clock;
+    app_config_reject(&result, GAME_CLOCK);
+  }
+  if (staged.play_warning >= staged.play_clock && (result.accepted & 1 << PLAY_WARNING)) {
+    staged.play_warning = app_config.play_warning;
+    app_config_reject(&result, PLAY_WARNING);
+  }
+  if (staged.play_warning >= staged.play_clock) {
+    staged.play_clock = app_config.play_clock;
+    app_config_reject(&result, PLAY_CLOCK);
+  }
+  // Going back field by field can still leave a mix that does not fit,
+  // in which case none of the message is taken
+  if (!app_config_valid(&staged)) {
+    staged = app_config;
+    result.rejected |= result.accepted & ~(1 << RESET);
+    result.accepted &= 1 << RESET;
+  }
+  if (!app_config_equal(&staged, &app_config)) {
+    app_config = staged;
+    persist_write_data(CONFIG_KEY, &app_config, sizeof(AppConfig));
+    activity_count(ACTIVITY_FLASH);
+    result.changed = true;
+  }
+  if (result.rejected) {
+    APP_LOG(APP_LOG_LEVEL_WARNING, "Config rejected 0x%05lx", (unsigned long)result.rejected);
+  }
+  return result;
+}
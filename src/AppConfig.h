@@ -1,5 +1,34 @@
 #pragma once
 #include <pebble.h>
+
+// The break clock's timeout length, half time is set from the menu
+#define BREAK_CLOCK_SECONDS 90
+
+// Double and triple clicks on the main window that log an event in one go
+typedef enum {
+  CHORD_UP_DOUBLE,
+  CHORD_UP_TRIPLE,
+  CHORD_SELECT_DOUBLE,
+  CHORD_SELECT_TRIPLE,
+  CHORD_COUNT
+} Chord;
+
+// What a chord logs, see game_data_shortcut
+typedef enum {
+  SHORTCUT_NONE,
+  SHORTCUT_HOME_TOUCHDOWN,
+  SHORTCUT_AWAY_TOUCHDOWN,
+  SHORTCUT_HOME_FIELD_GOAL,
+  SHORTCUT_AWAY_FIELD_GOAL,
+  SHORTCUT_HOME_SAFETY,
+  SHORTCUT_AWAY_SAFETY,
+  SHORTCUT_TRY_2,
+  SHORTCUT_TRY_1,
+  SHORTCUT_TRY_FAILED,
+  SHORTCUT_HOME_TIMEOUT,
+  SHORTCUT_AWAY_TIMEOUT,
+  SHORTCUT_COUNT
+} Shortcut;
   
 typedef struct AppConfig_t {
   uint16_t version;
@@ -8,9 +37,32 @@ typedef struct AppConfig_t {
   uint8_t timeouts;
   uint8_t periods;
   uint8_t post_snap;
+  // Seconds left on each clock when the official is warned, 0 for none.
+  // The game clock only warns in the quarter ending each half and in
+  // overtime, as a two-minute warning. The break warning has to fit a
+  // timeout.
+  uint16_t game_warning;
+  uint8_t play_warning;
+  uint8_t break_warning;
+  // Shortcut for each Chord, all SHORTCUT_NONE unless set from the phone
+  uint8_t shortcuts[CHORD_COUNT];
+  // A double tap on the watch starts and stops the play clock
+  bool tap_control;
 } AppConfig;
 
+// What app_config_reload made of a message. accepted and rejected hold
+// one bit per message key, 1 << key.
+typedef struct AppConfigResult_t {
+  uint32_t accepted;
+  uint32_t rejected;
+  // The stored config differs from before the message
+  bool changed;
+  bool reset;
+} AppConfigResult;
+
 extern AppConfig app_config;
 
 void app_config_init();
-bool app_config_reload(DictionaryIterator* iterator);
\ No newline at end of file
+// Values that are out of range, or do not fit with the rest of the config,
+// are rejected and the old value kept. Flash is only written on a change.
+AppConfigResult app_config_reload(DictionaryIterator* iterator);
@@ -0,0 +1,280 @@
+#include <pebble.h>
+#include "Archive.h"
+#include "Activity.h"
+
+#define ARCHIVE_VERSION 1
+
+// The index key
+typedef struct ArchiveIndex_t {
+  uint8_t version;
+  uint8_t next;
+  uint8_t count;
+  uint8_t serial;
+} ArchiveIndex;
+
+// The first page starts with the summary, later ones with the game's serial.
+// Events past the last page are not kept, the totals in the summary are.
+static const uint16_t FIRST_PAGE_START = sizeof(ArchiveSummary);
+static const uint16_t PAGE_START = 1;
+
+// Each event starts with a tag byte, from the top:
+// home team (1) | kind (2) | new quarter (1) | value (4)
+// A value of VALUE_ESCAPE or more is followed by the value, then a new
+// quarter by the quarter. Last comes the change in clock seconds since the
+// last event on the page as a zigzag varint, small as the clock counts down.
+#define TAG_QUARTER 0x10
+#define VALUE_ESCAPE 15
+#define EVENT_CODED_MAX 6
+_Static_assert(EVENT_TIMEOUT <= 3, "event kinds should fit the tag");
+
+// Each page is coded on its own, so any one can be decoded without the others
+typedef struct Coder_t {
+  uint8_t quarter;
+  uint16_t seconds;
+} Coder;
+
+static void coder_start(Coder* coder) {
+  coder->quarter = UINT8_MAX;
+  coder->seconds = 0;
+}
+
+static uint8_t encode_event(Coder* coder, Event event, uint8_t* out) {
+  uint8_t value = event_value(event);
+  uint8_t quarter = event_quarter(event);
+  uint8_t size = 1;
+  out[0] = event_home(event) << 7 | event_kind(event) << 5 | (value < VALUE_ESCAPE ? value : VALUE_ESCAPE);
+  if (value >= VALUE_ESCAPE) out[size++] = value;
+  if (quarter != coder->quarter) {
+    out[0] |= TAG_QUARTER;
+    out[size++] = quarter;
+    coder->quarter = quarter;
+  }
+  int32_t delta = (int32_t)coder->seconds - event_seconds(event);
+  uint32_t zigzag = delta < 0 ? ((uint32_t)-delta << 1) - 1 : (uint32_t)delta << 1;
+  coder->seconds = event_seconds(event);
+  do {
+    out[size] = zigzag & 0x7F;
+    zigzag >>= 7;
+    if (zigzag) out[size] |= 0x80;
+    ++size;
+  } while (zigzag);
+  return size;
+}
+
+// Bytes used, 0 if the event runs past the end of the page
+static uint8_t decode_event(Coder* coder, const uint8_t* in, uint16_t size, Event* event) {
+  uint8_t used = 0;
+  if (used >= size) return 0;
+  uint8_t tag = in[used++];
+  uint8_t value = tag & 0xF;
+  if (value == VALUE_ESCAPE) {
+    if (used >= size) return 0;
+    value = in[used++];
+  }
+  if (tag & TAG_QUARTER) {
+    if (used >= size) return 0;
+    coder->quarter = in[used++];
+  }
+  uint32_t zigzag = 0;
+  for (uint8_t shift = 0; ; shift += 7) {
+    if (used >= size || shift > 14) return 0;
+    uint8_t byte = in[used++];
+    zigzag |= (uint32_t)(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) break;
+  }
+  int32_t delta = zigzag & 1 ? -(int32_t)((zigzag + 1) >> 1) : (int32_t)(zigzag >> 1);
+  coder->seconds -= delta;
+  *event = event_make(tag >> 7, (tag >> 5) & 0x3, value, coder->quarter, coder->seconds);
+  return used;
+}
+
+// Codes the events from first on while they fit in capacity bytes. With
+// no output it only counts them.
+static uint16_t encode_page(EventLog* log, uint16_t first, uint16_t capacity, uint8_t* out, uint8_t* count) {
+  Coder coder;
+  coder_start(&coder);
+  uint8_t coded[EVENT_CODED_MAX];
+  uint16_t used = 0;
+  *count = 0;
+  for (uint16_t i = first; i < event_log_size(log) && *count < UINT8_MAX; ++i) {
+    uint8_t size = encode_event(&coder, event_log_get(log, i), coded);
+    if (used + size > capacity) break;
+    if (out) memcpy(out + used, coded, size);
+    used += size;
+    ++*count;
+  }
+  return used;
+}
+
+static uint32_t slot_key(Archive* archive, uint8_t slot) {
+  return archive->key + 1 + slot * ARCHIVE_PAGES;
+}
+
+// Slot of the game index games before the most recent
+static uint8_t archive_slot(Archive* archive, uint8_t index) {
+  return (archive->next + ARCHIVE_GAMES - 1 - index) % ARCHIVE_GAMES;
+}
+
+void archive_init(Archive* archive, uint32_t key) {
+  ArchiveIndex index;
+  archive->key = key;
+  archive->next = 0;
+  archive->count = 0;
+  archive->serial = 0;
+  if (persist_read_data(key, &index, sizeof(index)) == sizeof(index) && index.version == ARCHIVE_VERSION
+      && index.next < ARCHIVE_GAMES && index.count <= ARCHIVE_GAMES) {
+    archive->next = index.next;
+    archive->count = index.count;
+    archive->serial = index.serial;
+  }
+}
+
+bool archive_add(Archive* archive, GameData* game) {
+  EventLog* log = &game->events;
+  if (event_log_empty(log) && game->quarter == 0) return false;
+  ArchiveSummary summary;
+  memset(&summary, 0, sizeof(summary));
+  summary.ended = time(NULL);
+  summary.home = game->home.total;
+  summary.away = game->away.total;
+  summary.quarter = game->quarter;
+  summary.serial = archive->serial + 1;
+
+  uint16_t starts[ARCHIVE_PAGES];
+  uint16_t first = 0;
+  for (uint8_t page = 0; page < ARCHIVE_PAGES && first < event_log_size(log); ++page) {
+    uint16_t start = page ? PAGE_START : FIRST_PAGE_START;
+    starts[page] = first;
+    encode_page(log, first, PERSIST_DATA_MAX_LENGTH - start, NULL, &summary.counts[page]);
+    first += summary.counts[page];
+  }
+
+  // The first page goes last, until it is written the slot still reads as
+  // the game it held before and the later pages as belonging to another
+  uint8_t buffer[PERSIST_DATA_MAX_LENGTH];
+  uint32_t key = slot_key(archive, archive->next);
+  uint8_t count;
+  for (uint8_t page = ARCHIVE_PAGES - 1; page > 0; --page) {
+    if (summary.counts[page]) {
+      buffer[0] = summary.serial;
+      uint16_t size = encode_page(log, starts[page], PERSIST_DATA_MAX_LENGTH - PAGE_START,
+                                  buffer + PAGE_START, &count);
+      persist_write_data(key + page, buffer, PAGE_START + size);
+      activity_count(ACTIVITY_FLASH);
+    } else if (persist_exists(key + page)) {
+      persist_delete(key + page);
+      activity_count(ACTIVITY_FLASH);
+    }
+  }
+  memcpy(buffer, &summary, sizeof(summary));
+  uint16_t size = encode_page(log, 0, PERSIST_DATA_MAX_LENGTH - FIRST_PAGE_START, buffer + FIRST_PAGE_START, &count);
+  int written = persist_write_data(key, buffer, FIRST_PAGE_START + size);
+  activity_count(ACTIVITY_FLASH);
+  if (written < 0) return false;
+
+  archive->serial = summary.serial;
+  archive->next = (archive->next + 1) % ARCHIVE_GAMES;
+  if (archive->count < ARCHIVE_GAMES) archive->count++;
+  ArchiveIndex index = { ARCHIVE_VERSION, archive->next, archive->count, archive->serial };
+  persist_write_data(archive->key, &index, sizeof(index));
+  activity_count(ACTIVITY_FLASH);
+  return true;
+}
+
+uint8_t archive_count(Archive* archive) {
+  return archive->count;
+}
+
+bool archive_summary(Archive* archive, uint8_t index, ArchiveSummary* summary) {
+  if (index >= archive->count) return false;
+  uint32_t key = slot_key(archive, archive_slot(archive, index));
+  return persist_read_data(key, summary, sizeof(ArchiveSummary)) == sizeof(ArchiveSummary);
+}
+
+struct ArchiveReader_t {
+  uint32_t key;
+  ArchiveSummary summary;
+  // The page held and the index of its first event
+  uint8_t page;
+  uint16_t first;
+  uint16_t size;
+  bool valid;
+  // How far into the page has been decoded, and the last event decoded
+  uint16_t offset;
+  uint16_t decoded;
+  Coder coder;
+  Event last;
+  uint8_t data[PERSIST_DATA_MAX_LENGTH];
+};
+
+static void reader_rewind(ArchiveReader* reader) {
+  reader->offset = reader->page ? PAGE_START : FIRST_PAGE_START;
+  reader->decoded = 0;
+  coder_start(&reader->coder);
+}
+
+static void reader_load(ArchiveReader* reader, uint8_t page, uint16_t first) {
+  int size = persist_read_data(reader->key + page, reader->data, sizeof(reader->data));
+  reader->page = page;
+  reader->first = first;
+  reader->size = size > 0 ? size : 0;
+  reader->valid = page ? size >= PAGE_START && reader->data[0] == reader->summary.serial
+                       : size >= FIRST_PAGE_START;
+  reader_rewind(reader);
+}
+
+ArchiveReader* archive_open(Archive* archive, uint8_t index) {
+  if (index >= archive->count) return NULL;
+  ArchiveReader* reader = malloc(sizeof(ArchiveReader));
+  if (!reader) return NULL;
+  reader->key = slot_key(archive, archive_slot(archive, index));
+  memset(&reader->summary, 0, sizeof(reader->summary));
+  reader_load(reader, 0, 0);
+  if (!reader->valid) {
+    free(reader);
+    return NULL;
+  }
+  memcpy(&reader->summary, reader->data, sizeof(reader->summary));
+  return reader;
+}
+
+void archive_close(ArchiveReader* reader) {
+  free(reader);
+}
+
+const ArchiveSummary* archive_reader_summary(ArchiveReader* reader) {
+  return &reader->summary;
+}
+
+uint16_t archive_reader_count(ArchiveReader* reader) {
+  uint16_t count = 0;
+  for (uint8_t page = 0; page < ARCHIVE_PAGES; ++page) count += reader->summary.counts[page];
+  return count;
+}
+
+bool archive_reader_get(ArchiveReader* reader, uint16_t index, Event* event) {
+  uint8_t page = 0;
+  uint16_t first = 0;
+  while (index >= first + reader->summary.counts[page]) {
+    first += reader->summary.counts[page];
+    if (++page == ARCHIVE_PAGES) return false;
+  }
+  if (page != reader->page) reader_load(reader, page, first);
+  if (!reader->valid) return false;
+  // Menus draw their rows in order, so carry on from the last one unless
+  // going back
+  uint16_t row = index - first;
+  if (row + 1 < reader->decoded) reader_rewind(reader);
+  while (reader->decoded <= row) {
+    uint8_t used = decode_event(&reader->coder, reader->data + reader->offset,
+                                reader->size - reader->offset, &reader->last);
+    if (!used) {
+      reader->valid = false;
+      return false;
+    }
+    reader->offset += used;
+    reader->decoded++;
+  }
+  *event = reader->last;
+  return true;
+}
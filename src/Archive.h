@@ -0,0 +1,50 @@
+#pragma once
+#include "GameData.h"
+
+// Finished games, kept in a ring of slots after an index key so the oldest
+// is replaced once it is full. Each slot takes up to ARCHIVE_PAGES keys.
+// Events are delta and varint coded, a typical game takes one key.
+#define ARCHIVE_GAMES 8
+#define ARCHIVE_PAGES 3
+
+typedef struct Archive_t {
+  uint32_t key;
+  // Slot the next game goes in, and how many are kept
+  uint8_t next;
+  uint8_t count;
+  // Numbers each game so that pages left over from an older one are
+  // told apart
+  uint8_t serial;
+} Archive;
+
+// The start of a game's first page, which can be read on its own
+typedef struct ArchiveSummary_t {
+  // Wall time the game was archived
+  uint32_t ended;
+  uint16_t home;
+  uint16_t away;
+  uint8_t quarter;
+  uint8_t serial;
+  // Events coded on each page, 0 past the last
+  uint8_t counts[ARCHIVE_PAGES];
+} ArchiveSummary;
+
+// Reads the index key
+void archive_init(Archive* archive, uint32_t key);
+// False if the game has nothing to keep or could not be written
+bool archive_add(Archive* archive, GameData* game);
+uint8_t archive_count(Archive* archive);
+// Index 0 is the most recent game
+bool archive_summary(Archive* archive, uint8_t index, ArchiveSummary* summary);
+
+// One game's events, decoded a page at a time as they are asked for so
+// that only one page is held in memory
+struct ArchiveReader_t;
+typedef struct ArchiveReader_t ArchiveReader;
+
+ArchiveReader* archive_open(Archive* archive, uint8_t index);
+void archive_close(ArchiveReader* reader);
+const ArchiveSummary* archive_reader_summary(ArchiveReader* reader);
+uint16_t archive_reader_count(ArchiveReader* reader);
+// False if the page holding the event is missing or belongs to another game
+bool archive_reader_get(ArchiveReader* reader, uint16_t index, Event* event);
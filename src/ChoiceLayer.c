@@ -1,11 +1,17 @@
 #include <pebble.h>
 #include "ChoiceLayer.h"
+#include "Trace.h"
+#include "Activity.h"
 
 struct ChoiceLayer_t {
   Layer* layer;
   void* context;
   ChoiceLayerCallback callback;
-  const char** choices; 
+  const char* const* choices; 
+  // Looked up once, and the layout worked out from the bounds at create
+  GFont font;
+  uint8_t spacing;
+  int16_t width;
 };
 
 static void draw_triangle(GContext* ctx, GPoint p0, GPoint p1, GPoint p2) {
@@ -14,8 +20,7 @@ static void draw_triangle(GContext* ctx, GPoint p0, GPoint p1, GPoint p2) {
   graphics_draw_line(ctx, p2, p0);
 }
 
-static void draw_item(GContext* ctx, uint8_t y_offset, uint8_t height, const char* text) {
-  GFont font = fonts_get_system_font(FONT_KEY_GOTHIC_24_BOLD);
+static void draw_item(GContext* ctx, GFont font, uint8_t y_offset, uint8_t height, const char* text) {
   uint8_t font_y = (height - 24) / 2 + y_offset;
   graphics_draw_text(ctx, text, font, (GRect){
     .origin = {.x = 10, .y = font_y - 4}, .size = {.w = 100, .h = 24}
@@ -28,23 +33,19 @@ static void draw_item(GContext* ctx, uint8_t y_offset, uint8_t height, const cha
 }
 
 static void choicelayer_draw(Layer* layer, GContext* ctx) {
-  
+  TRACE_BEGIN(TRACE_DRAW_CHOICE, 0);
+  activity_count(ACTIVITY_REDRAW);
   graphics_context_set_text_color(ctx, GColorBlack);
   graphics_context_set_stroke_color(ctx, GColorBlack);
   graphics_context_set_fill_color(ctx, GColorWhite);
   
-  GRect bounds = layer_get_bounds(layer);
-  uint8_t spacing = bounds.size.h / 3;
-  
   ChoiceLayer* cl = *(ChoiceLayer**)layer_get_data(layer);
-  APP_LOG(APP_LOG_LEVEL_DEBUG, "Begin Choice Draw");
-  APP_LOG(APP_LOG_LEVEL_DEBUG, "First item: %s", cl->choices[0]);
-  draw_item(ctx, 0, spacing, cl->choices[0]);
-  draw_item(ctx, spacing, spacing, cl->choices[1]);
-  draw_item(ctx, spacing * 2, spacing, cl->choices[2]);
+  uint8_t spacing = cl->spacing;
+  for (int i = 0; i < 3; ++i) draw_item(ctx, cl->font, spacing * i, spacing, cl->choices[i]);
   
-  graphics_draw_line(ctx, (GPoint){.x = 0, .y = spacing}, (GPoint){.x = bounds.size.w, .y = spacing});
-  graphics_draw_line(ctx, (GPoint){.x = 0, .y = spacing * 2}, (GPoint){.x = bounds.size.w, .y = spacing * 2});
+  graphics_draw_line(ctx, (GPoint){.x = 0, .y = spacing}, (GPoint){.x = cl->width, .y = spacing});
+  graphics_draw_line(ctx, (GPoint){.x = 0, .y = spacing * 2}, (GPoint){.x = cl->width, .y = spacing * 2});
+  TRACE_END(TRACE_DRAW_CHOICE, 0);
 }
 
 static void up_click(ClickRecognizerRef re, void* context) {
@@ -72,6 +73,9 @@ ChoiceLayer* choicelayer_create(GRect rect) {
   ChoiceLayer* ret = (ChoiceLayer*)calloc(1, sizeof(ChoiceLayer));
   if (!ret) return ret;
   ret->layer = layer_create_with_data(rect, sizeof(void*));
+  ret->font = fonts_get_system_font(FONT_KEY_GOTHIC_24_BOLD);
+  ret->spacing = rect.size.h / 3;
+  ret->width = rect.size.w;
   layer_set_update_proc(ret->layer, choicelayer_draw);
   void** data = layer_get_data(ret->layer);
   *data = ret;
@@ -98,9 +102,12 @@ Layer* choicelayer_get_layer(ChoiceLayer* layer) {
   return layer->layer;
 }
 
-void choicelayer_set_choices(ChoiceLayer* layer, const char** choices) {
+void choicelayer_set_choices(ChoiceLayer* layer, const char* const* choices) {
+  // The labels are constant, the same menu again shows nothing new
+  if (layer->choices == choices) return;
   layer->choices = choices;
   layer_mark_dirty(choicelayer_get_layer(layer));
+  activity_count(ACTIVITY_DIRTY);
 }
 
 void choicelayer_set_callback(ChoiceLayer* layer, ChoiceLayerCallback callback, void* context) {
@@ -12,6 +12,6 @@ void choicelayer_destroy(ChoiceLayer* layer);
 
 // get the underlying layer - this must be done
 Layer* choicelayer_get_layer(ChoiceLayer* layer);
-void choicelayer_set_choices(ChoiceLayer* layer, const char** choices);
+void choicelayer_set_choices(ChoiceLayer* layer, const char* const* choices);
 void choicelayer_set_callback(ChoiceLayer* layer, ChoiceLayerCallback callback, void* data);
 void choicelayer_set_window(ChoiceLayer* layer, Window* window);
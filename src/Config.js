@@ -1,7 +1,136 @@
+// Watch messages carry either configuration or, under SYNC, a frame for
+// the other officials' watches. Frames are passed through a WebSocket relay
+// as they are, the watches do the rest.
+var SYNC_KEY = 'SYNC';
+var relay = null;
+var outbox = [];
+var sending = false;
+
+function sendNext() {
+  if (sending || outbox.length === 0) return;
+  sending = true;
+  Pebble.sendAppMessage(outbox[0],
+    function() {
+      outbox.shift();
+      sending = false;
+      sendNext();
+    },
+    function() {
+      // The watch is busy, try again shortly
+      sending = false;
+      setTimeout(sendNext, 500);
+    });
+}
+
+function queueMessage(message) {
+  outbox.push(message);
+  sendNext();
+}
+
+function connectRelay() {
+  if (relay) {
+    relay.onclose = null;
+    relay.close();
+    relay = null;
+  }
+  var url = localStorage.getItem('relay');
+  if (!url) return;
+  relay = new WebSocket(url);
+  relay.binaryType = 'arraybuffer';
+  relay.onmessage = function(e) {
+    var message = {};
+    message[SYNC_KEY] = Array.prototype.slice.call(new Uint8Array(e.data));
+    queueMessage(message);
+  };
+  relay.onclose = function() {
+    relay = null;
+    setTimeout(connectRelay, 5000);
+  };
+}
+
 Pebble.addEventListener("ready", 
   function(e) {
-    console.log('Hello World!');
+    connectRelay();
+  });
+
+// Config fields by their key, which is their bit in the watch's reply
+var CONFIG_FIELDS = {
+  1: 'GAME_CLOCK', 2: 'PLAY_CLOCK', 3: 'TIMEOUTS', 4: 'PERIODS', 5: 'POST_SNAP', 6: 'RESET',
+  11: 'GAME_WARNING', 12: 'PLAY_WARNING', 13: 'BREAK_WARNING',
+  15: 'SHORTCUT_UP_DOUBLE', 16: 'SHORTCUT_UP_TRIPLE', 17: 'SHORTCUT_SELECT_DOUBLE', 18: 'SHORTCUT_SELECT_TRIPLE',
+  19: 'TAP_CONTROL'
+};
+
+function configFields(bits) {
+  return Object.keys(CONFIG_FIELDS).filter(function(key) {
+    return bits & (1 << key);
+  }).map(function(key) {
+    return CONFIG_FIELDS[key];
   });
+}
+
+// Trace records sent by a watch built with REFWATCH_TRACE, in the layout of
+// TraceRecord in Trace.h: 32-bit ms, 16-bit arg, event, end flag
+var TRACE_KEY = 'TRACE';
+var TRACE_RECORD_SIZE = 8;
+var TRACE_EVENTS = ['deadline', 'draw static', 'draw score', 'draw choice', 'game read', 'game write',
+                    'click', 'menu', 'frame'];
+var traceRecords = [];
+
+function traceUint(bytes, offset, size) {
+  var value = 0;
+  for (var i = size - 1; i >= 0; --i) value = value * 256 + bytes[offset + i];
+  return value;
+}
+
+function traceReceive(part) {
+  if (part[0] & 1) traceRecords = [];
+  for (var offset = 1; offset + TRACE_RECORD_SIZE <= part.length; offset += TRACE_RECORD_SIZE) {
+    traceRecords.push({
+      ms: traceUint(part, offset, 4),
+      arg: traceUint(part, offset + 4, 2),
+      event: part[offset + 6],
+      end: part[offset + 7]
+    });
+  }
+  if (!(part[0] & 2)) return;
+  // Times are from the first record, ends also show how long since their begin
+  var begun = {};
+  var first = traceRecords.length > 0 ? traceRecords[0].ms : 0;
+  console.log('Trace: ' + traceRecords.length + ' records');
+  traceRecords.forEach(function(record) {
+    var name = TRACE_EVENTS[record.event] || ('event ' + record.event);
+    var line = '+' + ((record.ms - first) >>> 0) + 'ms ' + name + (record.end ? ' end' : ' begin') +
+      ' ' + record.arg;
+    if (!record.end) {
+      begun[record.event] = record.ms;
+    } else if (record.event in begun) {
+      line += ' (' + ((record.ms - begun[record.event]) >>> 0) + 'ms)';
+      delete begun[record.event];
+    }
+    console.log(line);
+  });
+  traceRecords = [];
+}
+
+Pebble.addEventListener('appmessage', function(e) {
+  if (TRACE_KEY in e.payload) {
+    traceReceive(e.payload[TRACE_KEY]);
+    return;
+  }
+  if ('CONFIG_ACCEPTED' in e.payload) {
+    console.log('Config accepted: ' + configFields(e.payload.CONFIG_ACCEPTED).join(', '));
+    var rejected = configFields(e.payload.CONFIG_REJECTED);
+    if (rejected.length > 0) {
+      Pebble.showSimpleNotificationOnPebble('RefWatch', 'Settings not applied: ' + rejected.join(', '));
+    }
+    return;
+  }
+  var frame = e.payload[SYNC_KEY];
+  if (frame && relay && relay.readyState === WebSocket.OPEN) {
+    relay.send(new Uint8Array(frame).buffer);
+  }
+});
 
 Pebble.addEventListener('showConfiguration', function() {
   Pebble.openURL('http://cas.ee.ic.ac.uk/~pko11/RefWatch.html');
@@ -10,5 +139,11 @@ Pebble.addEventListener('showConfiguration', function() {
 Pebble.addEventListener('webviewclosed', function(e) {
   var decoded = JSON.parse(decodeURIComponent(e.response));
   console.log("Config returned: " + e.response);
-  Pebble.sendAppMessage(decoded);
+  // The relay address stays on the phone
+  if ('relay' in decoded) {
+    localStorage.setItem('relay', decoded.relay);
+    delete decoded.relay;
+    connectRelay();
+  }
+  queueMessage(decoded);
 });
\ No newline at end of file
@@ -0,0 +1,13 @@
+#include <pebble.h>
+#include "Crc.h"
+
+// Bit at a time, a table would cost 1KB of flash for data read once a launch
+uint32_t crc32(uint32_t crc, const void* data, size_t size) {
+  const uint8_t* bytes = (const uint8_t*)data;
+  crc = ~crc;
+  while (size--) {
+    crc ^= *bytes++;
+    for (int bit = 0; bit < 8; ++bit) crc = (crc >> 1) ^ (0xEDB88320u & -(crc & 1));
+  }
+  return ~crc;
+}
@@ -0,0 +1,6 @@
+#pragma once
+#include <pebble.h>
+
+// CRC-32 as used by zlib. Pass 0 to start, or the result so far to carry on
+// over another block.
+uint32_t crc32(uint32_t crc, const void* data, size_t size);
@@ -0,0 +1,150 @@
+#include <pebble.h>
+#include "Deadlines.h"
+#include "Trace.h"
+#include "Activity.h"
+
+static bool entry_before(const DeadlineEntry* a, uint32_t seconds, uint16_t ms) {
+  int32_t difference = (int32_t)(a->seconds - seconds);
+  return difference < 0 || (difference == 0 && a->ms < ms);
+}
+
+static bool heap_less(Deadlines* deadlines, uint8_t a, uint8_t b) {
+  const DeadlineEntry* other = &deadlines->heap[b];
+  return entry_before(&deadlines->heap[a], other->seconds, other->ms);
+}
+
+static void heap_swap(Deadlines* deadlines, uint8_t a, uint8_t b) {
+  DeadlineEntry entry = deadlines->heap[a];
+  deadlines->heap[a] = deadlines->heap[b];
+  deadlines->heap[b] = entry;
+  deadlines->position[deadlines->heap[a].id] = a;
+  deadlines->position[deadlines->heap[b].id] = b;
+}
+
+static void heap_up(Deadlines* deadlines, uint8_t index) {
+  while (index > 0) {
+    uint8_t parent = (index - 1) / 2;
+    if (!heap_less(deadlines, index, parent)) return;
+    heap_swap(deadlines, index, parent);
+    index = parent;
+  }
+}
+
+static void heap_down(Deadlines* deadlines, uint8_t index) {
+  for (;;) {
+    uint8_t smallest = index;
+    uint8_t left = index * 2 + 1;
+    uint8_t right = left + 1;
+    if (left < deadlines->size && heap_less(deadlines, left, smallest)) smallest = left;
+    if (right < deadlines->size && heap_less(deadlines, right, smallest)) smallest = right;
+    if (smallest == index) return;
+    heap_swap(deadlines, index, smallest);
+    index = smallest;
+  }
+}
+
+static void heap_remove(Deadlines* deadlines, uint8_t index) {
+  deadlines->position[deadlines->heap[index].id] = DEADLINES_MAX;
+  if (index == --deadlines->size) return;
+  uint8_t moved = deadlines->heap[deadlines->size].id;
+  deadlines->heap[index] = deadlines->heap[deadlines->size];
+  deadlines->position[moved] = index;
+  heap_up(deadlines, index);
+  heap_down(deadlines, deadlines->position[moved]);
+}
+
+static int32_t ms_until(uint32_t seconds, uint16_t ms) {
+  time_t now_seconds;
+  uint16_t now_ms;
+  time_ms(&now_seconds, &now_ms);
+  return (int32_t)(seconds - (uint32_t)now_seconds) * 1000 + (int32_t)ms - (int32_t)now_ms;
+}
+
+static void deadlines_handle(void* context);
+
+// Point the app timer at the earliest deadline, leaving it alone if it
+// already is
+static void deadlines_arm(Deadlines* deadlines) {
+  if (deadlines->firing) return;
+  if (deadlines->size == 0) {
+    if (deadlines->timer) {
+      app_timer_cancel(deadlines->timer);
+      deadlines->timer = NULL;
+    }
+    return;
+  }
+  DeadlineEntry* first = &deadlines->heap[0];
+  if (deadlines->timer && first->seconds == deadlines->armed_seconds && first->ms == deadlines->armed_ms) {
+    return;
+  }
+  int32_t wait = ms_until(first->seconds, first->ms);
+  if (wait < 0) wait = 0;
+  deadlines->armed_seconds = first->seconds;
+  deadlines->armed_ms = first->ms;
+  if (!deadlines->timer || !app_timer_reschedule(deadlines->timer, wait)) {
+    deadlines->timer = app_timer_register(wait, deadlines_handle, deadlines);
+  }
+}
+
+// Everything due goes in one wakeup
+static void deadlines_handle(void* context) {
+  Deadlines* deadlines = (Deadlines*)context;
+  uint16_t handled = 0;
+  TRACE_BEGIN(TRACE_DEADLINE, 0);
+  activity_count(ACTIVITY_WAKEUP);
+  deadlines->timer = NULL;
+  deadlines->firing = true;
+  while (deadlines->size > 0 && ms_until(deadlines->heap[0].seconds, deadlines->heap[0].ms) <= 0) {
+    uint8_t id = deadlines->heap[0].id;
+    heap_remove(deadlines, 0);
+    deadlines->handler(deadlines->context, id);
+    ++handled;
+  }
+  deadlines->firing = false;
+  deadlines_arm(deadlines);
+  TRACE_END(TRACE_DEADLINE, handled);
+}
+
+void deadlines_init(Deadlines* deadlines, DeadlineHandler handler, void* context) {
+  memset(deadlines, 0, sizeof(Deadlines));
+  memset(deadlines->position, DEADLINES_MAX, sizeof(deadlines->position));
+  deadlines->handler = handler;
+  deadlines->context = context;
+}
+
+void deadlines_deinit(Deadlines* deadlines) {
+  deadlines->size = 0;
+  memset(deadlines->position, DEADLINES_MAX, sizeof(deadlines->position));
+  deadlines_arm(deadlines);
+}
+
+void deadlines_set(Deadlines* deadlines, uint8_t id, uint32_t seconds, uint16_t ms) {
+  uint8_t index = deadlines->position[id];
+  if (index == DEADLINES_MAX) {
+    index = deadlines->size++;
+    deadlines->position[id] = index;
+  }
+  deadlines->heap[index] = (DeadlineEntry) { .seconds = seconds, .ms = ms, .id = id };
+  heap_up(deadlines, index);
+  heap_down(deadlines, deadlines->position[id]);
+  deadlines_arm(deadlines);
+}
+
+void deadlines_set_in(Deadlines* deadlines, uint8_t id, uint32_t ms) {
+  time_t seconds;
+  uint16_t now_ms;
+  time_ms(&seconds, &now_ms);
+  ms += now_ms;
+  deadlines_set(deadlines, id, (uint32_t)seconds + ms / 1000, ms % 1000);
+}
+
+void deadlines_clear(Deadlines* deadlines, uint8_t id) {
+  uint8_t index = deadlines->position[id];
+  if (index == DEADLINES_MAX) return;
+  heap_remove(deadlines, index);
+  deadlines_arm(deadlines);
+}
+
+bool deadlines_is_set(Deadlines* deadlines, uint8_t id) {
+  return deadlines->position[id] != DEADLINES_MAX;
+}
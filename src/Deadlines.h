@@ -0,0 +1,39 @@
+#pragma once
+#include <pebble.h>
+
+// A handful of deadlines behind a single app timer, which only ever wakes
+// for the earliest of them. Each deadline has a small id picked by the
+// owner, setting an id again moves it. Times are time_ms() readings.
+#define DEADLINES_MAX 8
+
+typedef void (*DeadlineHandler)(void* context, uint8_t id);
+
+typedef struct DeadlineEntry_t {
+  uint32_t seconds;
+  uint16_t ms;
+  uint8_t id;
+} DeadlineEntry;
+
+typedef struct Deadlines_t {
+  // Binary min-heap on the due time
+  DeadlineEntry heap[DEADLINES_MAX];
+  // Where each id sits in the heap, DEADLINES_MAX if it is not set
+  uint8_t position[DEADLINES_MAX];
+  uint8_t size;
+  AppTimer* timer;
+  // Deadline the timer was registered for
+  uint32_t armed_seconds;
+  uint16_t armed_ms;
+  bool firing;
+  DeadlineHandler handler;
+  void* context;
+} Deadlines;
+
+void deadlines_init(Deadlines* deadlines, DeadlineHandler handler, void* context);
+void deadlines_deinit(Deadlines* deadlines);
+
+void deadlines_set(Deadlines* deadlines, uint8_t id, uint32_t seconds, uint16_t ms);
+// Due the given number of milliseconds from now
+void deadlines_set_in(Deadlines* deadlines, uint8_t id, uint32_t ms);
+void deadlines_clear(Deadlines* deadlines, uint8_t id);
+bool deadlines_is_set(Deadlines* deadlines, uint8_t id);
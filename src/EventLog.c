@@ -0,0 +1,155 @@
+#include <pebble.h>
+#include "EventLog.h"
+#include "AppConfig.h"
+#include "Activity.h"
+static const int BYTES_PER_ENTRY = sizeof(Event);
+static const uint16_t EVENTS_PER_KEY = PERSIST_DATA_MAX_LENGTH / sizeof(Event);
+_Static_assert(EVENT_LOG_CAPACITY % (PERSIST_DATA_MAX_LENGTH / sizeof(Event)) == 0,
+               "event log should fill whole persist keys");
+
+Event event_make(bool home, EventKind kind, uint8_t value, uint8_t quarter, uint16_t seconds) {
+  if (quarter > 15) quarter = 15;
+  return ((uint32_t)home << 31) | ((uint32_t)kind << 28) | ((uint32_t)value << 20)
+      | ((uint32_t)quarter << 16) | seconds;
+}
+
+bool event_home(Event event) {
+  return event >> 31;
+}
+
+EventKind event_kind(Event event) {
+  return (event >> 28) & 0x7;
+}
+
+uint8_t event_value(Event event) {
+  return (event >> 20) & 0xFF;
+}
+
+uint8_t event_quarter(Event event) {
+  return (event >> 16) & 0xF;
+}
+
+uint16_t event_seconds(Event event) {
+  return event & 0xFFFF;
+}
+
+void event_log_init(EventLog* log) {
+  log->size = 0;
+  log->changes = 0;
+}
+
+uint16_t event_log_size(EventLog* log) {
+  return log->size;
+}
+
+bool event_log_empty(EventLog* log) {
+  return log->size == 0;
+}
+
+bool event_log_full(EventLog* log) {
+  return log->size == EVENT_LOG_CAPACITY;
+}
+
+bool event_log_push(EventLog* log, Event event) {
+  if (event_log_full(log)) return false;
+  log->data[log->size++] = event;
+  log->changes++;
+  return true;
+}
+
+Event event_log_pop(EventLog* log) {
+  log->changes++;
+  return log->data[--log->size];
+}
+
+Event event_log_get(EventLog* log, uint16_t index) {
+  return log->data[index];
+}
+
+void event_log_clear(EventLog* log) {
+  log->size = 0;
+  log->changes++;
+}
+
+uint16_t event_log_changes(EventLog* log) {
+  return log->changes;
+}
+
+static const char* ordinals[] = {"1st", "2nd", "3rd", "4th", "Overtime"};
+uint8_t quarter_index(uint8_t quarter) {
+  if (quarter < app_config.periods && quarter < PERIODS_MAX) return quarter;
+  else return PERIODS_MAX;
+}
+
+uint8_t quarter_half(uint8_t quarter) {
+  if (quarter < app_config.periods / 2) return 0;
+  else if (quarter < app_config.periods) return 1;
+  else return 2;
+}
+
+const char* quarter_to_text(uint8_t quarter) {
+  return ordinals[quarter_index(quarter)];
+}
+
+void event_row_text(Event event, char* title, uint16_t title_size, char* subtitle, uint16_t subtitle_size) {
+  const char* quarter = quarter_to_text(event_quarter(event));
+  uint8_t value = event_value(event);
+  uint16_t seconds = event_seconds(event);
+  switch (event_kind(event)) {
+  case EVENT_SCORE:
+    if (value == 6) snprintf(title, title_size, "Touchdown");
+    else if (value == 3) snprintf(title, title_size, "Field Goal");
+    else if (value == 2) snprintf(title, title_size, "Safety");
+    else snprintf(title, title_size, "%d points", value);
+    break;
+  case EVENT_TRY:
+    if (value) snprintf(title, title_size, "Try +%d", value);
+    else snprintf(title, title_size, "Try failed");
+    break;
+  case EVENT_PENALTY: snprintf(title, title_size, "Penalty #%d", value); break;
+  case EVENT_TIMEOUT: snprintf(title, title_size, "Timeout"); break;
+  }
+  if (seconds == EVENT_NO_TIME) snprintf(subtitle, subtitle_size, "%s", quarter);
+  else snprintf(subtitle, subtitle_size, "%s %02d:%02d", quarter, seconds / 60, seconds % 60);
+}
+
+void event_log_write(EventLog* log, uint16_t start, uint32_t key, uint8_t keys) {
+  for (uint8_t i = 0; i < keys; ++i, start += EVENTS_PER_KEY) {
+    if (start < log->size) {
+      uint16_t count = log->size - start;
+      if (count > EVENTS_PER_KEY) count = EVENTS_PER_KEY;
+      persist_write_data(key + i, &log->data[start], count * BYTES_PER_ENTRY);
+      activity_count(ACTIVITY_FLASH);
+    } else if (persist_exists(key + i)) {
+      persist_delete(key + i);
+      activity_count(ACTIVITY_FLASH);
+    }
+  }
+}
+
+bool event_log_read_count(EventLog* log, uint16_t count, uint32_t key) {
+  if (log->size + count > EVENT_LOG_CAPACITY) return false;
+  for (uint32_t i = 0; count > 0; ++i) {
+    uint16_t chunk = count < EVENTS_PER_KEY ? count : EVENTS_PER_KEY;
+    int size = persist_read_data(key + i, &log->data[log->size], chunk * BYTES_PER_ENTRY);
+    if (size != chunk * BYTES_PER_ENTRY) return false;
+    log->size += chunk;
+    log->changes++;
+    count -= chunk;
+  }
+  return true;
+}
+
+void event_log_read(EventLog* log, uint32_t key, uint8_t keys) {
+  event_log_clear(log);
+  for (uint8_t i = 0; i < keys; ++i) {
+    int size = persist_get_size(key + i);
+    if (size <= 0) return;
+    uint16_t count = (uint16_t)size / BYTES_PER_ENTRY;
+    if (log->size + count > EVENT_LOG_CAPACITY) count = EVENT_LOG_CAPACITY - log->size;
+    persist_read_data(key + i, &log->data[log->size], count * BYTES_PER_ENTRY);
+    log->size += count;
+    log->changes++;
+    if (count < EVENTS_PER_KEY) return;
+  }
+}
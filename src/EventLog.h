@@ -0,0 +1,67 @@
+#pragma once
+#include <pebble.h>
+
+// A game event packed into 32 bits, from the top:
+// home team (1) | kind (3) | value (8) | quarter (4) | game clock seconds (16)
+typedef uint32_t Event;
+
+typedef enum {
+  EVENT_SCORE,
+  EVENT_TRY,
+  EVENT_PENALTY,
+  EVENT_TIMEOUT
+} EventKind;
+
+// Clock seconds stored for events migrated from before they had a time
+#define EVENT_NO_TIME 0xFFFF
+
+Event event_make(bool home, EventKind kind, uint8_t value, uint8_t quarter, uint16_t seconds);
+bool event_home(Event event);
+EventKind event_kind(Event event);
+uint8_t event_value(Event event);
+uint8_t event_quarter(Event event);
+uint16_t event_seconds(Event event);
+// Row text for lists, such as "Field Goal" over "2nd 04:12"
+void event_row_text(Event event, char* title, uint16_t title_size, char* subtitle, uint16_t subtitle_size);
+
+// Fixed budget for a whole game, sized to what the snapshot keys can hold.
+// The log never allocates, a full log rejects new events instead.
+#define EVENT_LOG_CAPACITY 256
+
+typedef struct EventLog_t {
+  Event data[EVENT_LOG_CAPACITY];
+  uint16_t size;
+  // Counts every push, pop and clear, so views of the log know when to
+  // look again
+  uint16_t changes;
+} EventLog;
+
+void event_log_init(EventLog* log);
+
+uint16_t event_log_size(EventLog* log);
+bool event_log_empty(EventLog* log);
+bool event_log_full(EventLog* log);
+void event_log_clear(EventLog* log);
+// Returns false if the log is out of space
+bool event_log_push(EventLog* log, Event event);
+Event event_log_pop(EventLog* log);
+Event event_log_get(EventLog* log, uint16_t index);
+uint16_t event_log_changes(EventLog* log);
+
+// The events from start on, stored over consecutive keys starting at key.
+// Keys left over are deleted.
+void event_log_write(EventLog* log, uint16_t start, uint32_t key, uint8_t keys);
+// Appends count events stored by event_log_write, false if any are missing
+bool event_log_read_count(EventLog* log, uint16_t count, uint32_t key);
+// Before version 10 the keys held the whole log and were read until one
+// was short
+void event_log_read(EventLog* log, uint32_t key, uint8_t keys);
+
+// Periods with their own name, any later ones are overtime
+#define PERIODS_MAX 4
+
+const char* quarter_to_text(uint8_t quarter);
+// Index into per-period tables, overtime is PERIODS_MAX
+uint8_t quarter_index(uint8_t quarter);
+// 0 and 1 for the halves, 2 for overtime
+uint8_t quarter_half(uint8_t quarter);
@@ -1,41 +1,140 @@
 #include <pebble.h>
 #include "GameData.h"
 #include "AppConfig.h"
+#include "Trace.h"
+#include "Activity.h"
+#include "Crc.h"
   
+static void team_data_clear_totals(TeamData* team) {
+  team->total = 0;
+  memset(team->period_totals, 0, sizeof(team->period_totals));
+  memset(team->half_totals, 0, sizeof(team->half_totals));
+}
+
+static void team_data_add_points(TeamData* team, uint8_t quarter, int16_t points) {
+  uint8_t half = quarter_half(quarter);
+  team->total += points;
+  team->period_totals[quarter_index(quarter)] += points;
+  if (half < 2) team->half_totals[half] += points;
+}
+
+// Deadline ids, CLOCK_GAME to CLOCK_BREAK are each clock's expiry
+#define DEADLINE_TICK CLOCK_COUNT
+#define DEADLINE_ALERT (CLOCK_COUNT + 1)
+_Static_assert(DEADLINE_ALERT < DEADLINES_MAX, "every clock needs a deadline");
+
+static void game_data_deadline(void* context, uint8_t id);
+
 void game_data_init(GameData* data) {
-  game_list_init(&data->home.scores);
-  game_list_init(&data->away.scores);
-  game_list_init(&data->home.penalties);
-  game_list_init(&data->away.penalties);
+  event_log_init(&data->events);
+  memset(data->clock_callbacks, 0, sizeof(data->clock_callbacks));
+  data->on_tick = NULL;
+  deadlines_init(&data->deadlines, game_data_deadline, data);
+  data->alert_count = 0;
+  data->next_alert = 0;
+  data->listener = NULL;
+  data->listener_context = NULL;
+  data->generation = 0;
 }
 void game_data_free(GameData* data) {
-  if (data->timer_callbacks.timer) {
-    app_timer_cancel(data->timer_callbacks.timer);
-    data->timer_callbacks.timer = NULL;
-  }
-  game_list_free(&data->home.scores);
-  game_list_free(&data->away.scores);
-  game_list_free(&data->home.penalties);
-  game_list_free(&data->away.penalties);
+  deadlines_deinit(&data->deadlines);
+}
+static void game_data_announce_reset(GameData* data);
+static void clock_halt(GameData* data, ClockId clock);
+
+// Every clock stopped at its configured length
+static void clocks_default(Timer* clocks) {
+  memset(clocks, 0, sizeof(Timer) * CLOCK_COUNT);
+  clocks[CLOCK_GAME].reset_to = app_config.game_clock;
+  clocks[CLOCK_PLAY].reset_to = app_config.play_clock;
+  clocks[CLOCK_BREAK].reset_to = BREAK_CLOCK_SECONDS;
+  for (int i = 0; i < CLOCK_COUNT; ++i) clocks[i].initial = clocks[i].reset_to * 1000;
 }
+
 void game_data_reset(GameData* data) {
-  game_list_clear(&data->home.scores);
-  game_list_clear(&data->away.scores);
-  game_list_clear(&data->home.penalties);
-  game_list_clear(&data->away.penalties);
-  data->home.total = 0;
-  data->away.total = 0;
+  // Other watches do the same reset themselves, so the clocks are set
+  // without recording them and the whole reset counts as one change
+  game_data_announce_reset(data);
+  uint16_t revision = data->revision + 1;
+  event_log_clear(&data->events);
+  team_data_clear_totals(&data->home);
+  team_data_clear_totals(&data->away);
   data->home.timeouts = app_config.timeouts;
   data->away.timeouts = app_config.timeouts;
   data->quarter = 0;
   data->try_active = false;
   data->home_team_active = false;
-  game_data_timer_reset(data);
+  for (int i = 0; i < CLOCK_COUNT; ++i) {
+    if (!data->clocks[i].running) continue;
+    clock_halt(data, i);
+    if (data->clock_callbacks[i].on_stop) data->clock_callbacks[i].on_stop(i);
+  }
+  clocks_default(data->clocks);
+  data->shown = CLOCK_GAME;
+  data->post_snap = false;
+  if (data->on_tick) data->on_tick(NULL);
+  data->revision = revision;
+  game_data_write(data, data->key);
 }
 
-static const uint32_t STORAGE_VERSION = 4;
+static const uint32_t STORAGE_VERSION = 10;
+static const uint8_t EVENT_LOG_KEYS = 4;
+// A snapshot is a record and EVENT_LOG_KEYS keys for the events that do not
+// fit in it. Two banks of them take turns, so a snapshot cut short by the
+// app dying leaves the one before it to fall back on, unless the journal has
+// moved on too far since.
+static const uint32_t BANK_KEYS = 5;
+static const uint32_t JOURNAL_OFFSET = 10;
+static const uint8_t JOURNAL_SLOTS = 16;
 
 typedef struct GameDataStorage_t {
+  uint32_t version;
+  // Bytes after crc that it covers, here and in the events after it
+  uint16_t length;
+  // The newer bank has the higher generation, allowing for wrap
+  uint16_t generation;
+  uint32_t crc;
+  uint16_t event_count;
+  Timer clocks[CLOCK_COUNT];
+  uint8_t home_timeouts;
+  uint8_t away_timeouts;
+  uint8_t quarter;
+  uint8_t try_active;
+  uint8_t home_team_active;
+  uint8_t shown;
+  uint8_t post_snap;
+  uint16_t journal_seq;
+  uint16_t revision;
+} GameDataStorage;
+
+// Events after the storage in the same record, enough for most games to
+// come back with just the two bank records
+#define SNAPSHOT_EVENTS ((PERSIST_DATA_MAX_LENGTH - sizeof(GameDataStorage)) / sizeof(Event))
+
+typedef struct Snapshot_t {
+  GameDataStorage storage;
+  Event events[SNAPSHOT_EVENTS];
+} Snapshot;
+
+// Version 9 was the storage alone, with the events in the EVENT_LOG_KEYS
+// keys after it
+typedef struct GameDataStorageV9_t {
+  uint32_t version;
+  Timer clocks[CLOCK_COUNT];
+  uint8_t home_timeouts;
+  uint8_t away_timeouts;
+  uint8_t quarter;
+  uint8_t try_active;
+  uint8_t home_team_active;
+  uint8_t shown;
+  uint8_t post_snap;
+  uint16_t journal_seq;
+  uint16_t revision;
+} GameDataStorageV9;
+
+// Version 8 had a single timer switched between the clocks, play_clock
+// was 0 for the game clock, 1 for the play clock and 2 after the snap
+typedef struct GameDataStorageV8_t {
   uint32_t version;
   Timer timer;
   uint8_t home_timeouts;
@@ -44,139 +143,803 @@ typedef struct GameDataStorage_t {
   uint8_t try_active;
   uint8_t home_team_active;
   uint8_t play_clock;
-} GameDataStorage;
+  uint16_t journal_seq;
+  uint16_t revision;
+} GameDataStorageV8;
 
-bool game_data_read(GameData* data, uint32_t key) {
-  if (!persist_exists(key)) return false;
+// Version 4 stored the timer as doubles in seconds. The raw IEEE-754 bits
+// are kept as integers so that migrating doesn't pull in soft-float.
+typedef struct TimerV4_t {
+  uint64_t initial;
+  uint64_t started;
+  bool running;
+  uint16_t reset_to;
+} TimerV4;
+
+typedef struct GameDataStorageV4_t {
+  uint32_t version;
+  TimerV4 timer;
+  uint8_t home_timeouts;
+  uint8_t away_timeouts;
+  uint8_t quarter;
+  uint8_t try_active;
+  uint8_t home_team_active;
+  uint8_t play_clock;
+} GameDataStorageV4;
+
+// Convert a non-negative double of seconds to milliseconds, rounded to nearest
+static uint64_t double_bits_to_ms(uint64_t bits) {
+  if (bits >> 63) return 0;
+  int exponent = (int)((bits >> 52) & 0x7FF) - 1075;
+  uint64_t mantissa = bits & 0xFFFFFFFFFFFFFull;
+  if (exponent == -1075) return 0;
+  mantissa |= 1ull << 52;
+  if (exponent >= 0) return UINT64_MAX;
+  if (exponent < -63) return 0;
+  uint64_t scaled = mantissa * 1000;
+  int shift = -exponent;
+  return (scaled + (1ull << (shift - 1))) >> shift;
+}
+
+static void game_data_storage_migrate_v4(GameDataStorageV8* storage, GameDataStorageV4* old) {
+  uint64_t started = double_bits_to_ms(old->timer.started);
+  storage->version = 8;
+  storage->timer.initial = (uint32_t)double_bits_to_ms(old->timer.initial);
+  storage->timer.started = (uint32_t)(started / 1000);
+  storage->timer.started_ms = (uint16_t)(started % 1000);
+  storage->timer.running = old->timer.running;
+  storage->timer.reset_to = old->timer.reset_to;
+  storage->home_timeouts = old->home_timeouts;
+  storage->away_timeouts = old->away_timeouts;
+  storage->quarter = old->quarter;
+  storage->try_active = old->try_active;
+  storage->home_team_active = old->home_team_active;
+  storage->play_clock = old->play_clock;
+  storage->journal_seq = 0;
+  storage->revision = 0;
+}
+
+// The single timer becomes whichever clock it was last used as, the others
+// start from their configured length
+static void game_data_storage_migrate_v8(GameDataStorage* storage, GameDataStorageV8* old) {
+  ClockId clock = old->play_clock ? CLOCK_PLAY : CLOCK_GAME;
+  memset(storage, 0, sizeof(GameDataStorage));
+  storage->version = STORAGE_VERSION;
+  clocks_default(storage->clocks);
+  storage->clocks[clock] = old->timer;
+  storage->home_timeouts = old->home_timeouts;
+  storage->away_timeouts = old->away_timeouts;
+  storage->quarter = old->quarter;
+  storage->try_active = old->try_active;
+  storage->home_team_active = old->home_team_active;
+  storage->shown = clock;
+  storage->post_snap = old->play_clock == 2;
+  storage->journal_seq = old->journal_seq;
+  storage->revision = old->revision;
+}
+
+static void game_data_storage_migrate_v9(GameDataStorage* storage, GameDataStorageV9* old) {
+  memset(storage, 0, sizeof(GameDataStorage));
+  storage->version = STORAGE_VERSION;
+  memcpy(storage->clocks, old->clocks, sizeof(storage->clocks));
+  storage->home_timeouts = old->home_timeouts;
+  storage->away_timeouts = old->away_timeouts;
+  storage->quarter = old->quarter;
+  storage->try_active = old->try_active;
+  storage->home_team_active = old->home_team_active;
+  storage->shown = old->shown;
+  storage->post_snap = old->post_snap;
+  storage->journal_seq = old->journal_seq;
+  storage->revision = old->revision;
+}
+
+// Everything after the crc field, then the events
+static const size_t SNAPSHOT_COVERED = sizeof(GameDataStorage) - offsetof(GameDataStorage, crc) - sizeof(uint32_t);
+
+static uint32_t snapshot_crc(const GameDataStorage* storage, const Event* events, uint16_t count) {
+  const uint8_t* covered = (const uint8_t*)storage + sizeof(GameDataStorage) - SNAPSHOT_COVERED;
+  return crc32(crc32(0, covered, SNAPSHOT_COVERED), events, count * sizeof(Event));
+}
+
+static uint16_t snapshot_record_events(uint16_t count) {
+  return count < SNAPSHOT_EVENTS ? count : SNAPSHOT_EVENTS;
+}
+
+// The header of a snapshot, before its events are read
+static bool snapshot_plausible(const GameDataStorage* storage, int size) {
+  return size >= (int)sizeof(GameDataStorage) && storage->version == STORAGE_VERSION
+      && storage->event_count <= EVENT_LOG_CAPACITY
+      && storage->length == SNAPSHOT_COVERED + storage->event_count * sizeof(Event);
+}
+
+// Takes the snapshot read from the record at bank once its events are all
+// there and match the crc. The events are left in data either way.
+static bool snapshot_restore(GameData* data, GameDataStorage* storage, const Snapshot* snapshot, int size,
+                             uint32_t bank) {
+  const GameDataStorage* found = &snapshot->storage;
+  if (!snapshot_plausible(found, size)) return false;
+  uint16_t in_record = snapshot_record_events(found->event_count);
+  if (size != (int)(sizeof(GameDataStorage) + in_record * sizeof(Event))) return false;
+  event_log_clear(&data->events);
+  for (uint16_t i = 0; i < in_record; ++i) event_log_push(&data->events, snapshot->events[i]);
+  if (!event_log_read_count(&data->events, found->event_count - in_record, bank + 1)) return false;
+  if (snapshot_crc(found, data->events.data, found->event_count) != found->crc) return false;
+  *storage = *found;
+  return true;
+}
+
+// Just the header of the snapshot in a bank, to see which bank is newer
+static bool snapshot_peek(uint32_t bank, GameDataStorage* storage) {
+  int size = persist_read_data(bank, storage, sizeof(GameDataStorage));
+  return snapshot_plausible(storage, size);
+}
+
+// Returns the version that was found, or 0 if nothing usable was stored.
+// Version 10 snapshots come with their events, older ones without. Only the
+// newer bank is read whole, the other one just when that fails its crc.
+static uint32_t game_data_storage_read(GameData* data, GameDataStorage* storage, uint32_t key) {
+  union {
+    uint32_t version;
+    Snapshot current;
+    GameDataStorageV9 v9;
+    GameDataStorageV8 v8;
+    GameDataStorageV4 v4;
+  } buffer;
+  GameDataStorage headers[2];
+  bool found[2] = { snapshot_peek(key, &headers[0]), snapshot_peek(key + BANK_KEYS, &headers[1]) };
+  uint8_t newer = found[1] && (!found[0] || (int16_t)(headers[1].generation - headers[0].generation) > 0);
+  for (uint8_t i = 0; i < 2; ++i) {
+    uint8_t bank = i ? !newer : newer;
+    if (!found[bank]) continue;
+    uint32_t at = key + bank * BANK_KEYS;
+    int size = persist_read_data(at, &buffer, sizeof(buffer));
+    if (snapshot_restore(data, storage, &buffer.current, size, at)) return STORAGE_VERSION;
+    APP_LOG(APP_LOG_LEVEL_WARNING, "Snapshot bank %d damaged", bank);
+  }
+  // Older versions kept the game where bank 0's record is now
+  int size = persist_read_data(key, &buffer, sizeof(buffer));
+  if (size == sizeof(GameDataStorageV9) && buffer.version == 9) {
+    game_data_storage_migrate_v9(storage, &buffer.v9);
+    return 9;
+  }
+  if (size == sizeof(GameDataStorageV8) && buffer.version == 8) {
+    game_data_storage_migrate_v8(storage, &buffer.v8);
+    return 8;
+  }
+  if (size == sizeof(GameDataStorageV4) && buffer.version == 4) {
+    GameDataStorageV8 v8;
+    game_data_storage_migrate_v4(&v8, &buffer.v4);
+    game_data_storage_migrate_v8(storage, &v8);
+    return 4;
+  }
+  return 0;
+}
+
+// Version 4 kept four lists of (quarter << 8 | value), with the try folded
+// into the touchdown's value
+static void game_data_read_v4_list(GameData* data, uint32_t key, bool home, EventKind kind) {
+  uint16_t entries[PERSIST_DATA_MAX_LENGTH / 2];
+  int size = persist_read_data(key, entries, sizeof(entries));
+  for (int i = 0; i < size / 2; ++i) {
+    uint8_t value = entries[i] & 0x00FF;
+    uint8_t quarter = entries[i] >> 8;
+    if (kind == EVENT_SCORE && value > 6 && value <= 8) {
+      event_log_push(&data->events, event_make(home, EVENT_SCORE, 6, quarter, EVENT_NO_TIME));
+      event_log_push(&data->events, event_make(home, EVENT_TRY, value - 6, quarter, EVENT_NO_TIME));
+    } else {
+      event_log_push(&data->events, event_make(home, kind, value, quarter, EVENT_NO_TIME));
+    }
+  }
+}
+
+typedef enum {
+  RECORD_EVENT,
+  RECORD_UNDO,
+  RECORD_QUARTER,
+  RECORD_CLOCK,
+  // Only sent to other watches, a reset takes a snapshot instead
+  RECORD_RESET,
+  RECORD_STATE
+} GameRecordType;
+
+// Everything not rebuilt by replaying the log or the clock records, ends
+// an export
+typedef struct GameState_t {
+  uint8_t quarter;
+  uint8_t home_timeouts;
+  uint8_t away_timeouts;
+  bool try_active;
+  bool home_team_active;
+  uint16_t revision;
+} GameState;
+
+// Journal record, the payload depends on the type
+typedef struct GameRecord_t {
+  uint8_t type;
+  // ClockId of a RECORD_CLOCK
+  uint8_t clock;
+  union {
+    Event event;
+    Timer timer;
+    GameState state;
+  } payload;
+} GameRecord;
+
+static const int RECORD_HEADER = offsetof(GameRecord, payload);
+_Static_assert(sizeof(GameRecord) <= JOURNAL_RECORD_MAX, "GameRecord must fit a journal entry");
+
+static TeamData* game_data_team(GameData* data, bool home) {
+  return home ? &data->home : &data->away;
+}
+
+// Totals and timeouts are kept in step with the log so that undo is O(1)
+static void game_data_apply_event(GameData* data, Event event) {
+  if (!event_log_push(&data->events, event)) return;
+  TeamData* team = game_data_team(data, event_home(event));
+  uint8_t value = event_value(event);
+  switch (event_kind(event)) {
+  case EVENT_SCORE:
+    data->home_team_active = event_home(event);
+    if (value == 6) data->try_active = true;
+    team_data_add_points(team, event_quarter(event), value);
+    break;
+  case EVENT_TRY:
+    data->try_active = false;
+    team_data_add_points(team, event_quarter(event), value);
+    break;
+  case EVENT_PENALTY:
+    break;
+  case EVENT_TIMEOUT:
+    if (team->timeouts) team->timeouts--;
+    break;
+  }
+}
+
+static void game_data_apply_undo(GameData* data) {
+  if (event_log_empty(&data->events)) return;
+  Event event = event_log_pop(&data->events);
+  TeamData* team = game_data_team(data, event_home(event));
+  uint8_t value = event_value(event);
+  switch (event_kind(event)) {
+  case EVENT_SCORE:
+    data->try_active = false;
+    team_data_add_points(team, event_quarter(event), -value);
+    break;
+  case EVENT_TRY:
+    data->try_active = true;
+    data->home_team_active = event_home(event);
+    team_data_add_points(team, event_quarter(event), -value);
+    break;
+  case EVENT_PENALTY:
+    break;
+  case EVENT_TIMEOUT:
+    if (team->timeouts < app_config.timeouts) team->timeouts++;
+    break;
+  }
+}
+
+static void game_data_apply(GameData* data, const GameRecord* record) {
+  data->revision++;
+  switch (record->type) {
+  case RECORD_EVENT:
+    game_data_apply_event(data, record->payload.event);
+    break;
+  case RECORD_UNDO:
+    game_data_apply_undo(data);
+    break;
+  case RECORD_QUARTER:
+    if (++data->quarter == app_config.periods / 2) {
+      data->home.timeouts = app_config.timeouts;
+      data->away.timeouts = app_config.timeouts;
+    }
+    break;
+  case RECORD_CLOCK:
+    if (record->clock < CLOCK_COUNT) data->clocks[record->clock] = record->payload.timer;
+    break;
+  case RECORD_STATE:
+    data->quarter = record->payload.state.quarter;
+    data->home.timeouts = record->payload.state.home_timeouts;
+    data->away.timeouts = record->payload.state.away_timeouts;
+    data->try_active = record->payload.state.try_active;
+    data->home_team_active = record->payload.state.home_team_active;
+    data->revision = record->payload.state.revision;
+    break;
+  case RECORD_RESET:
+    break;
+  }
+}
+
+static void game_data_replay(void* context, const void* data, uint16_t size) {
+  GameRecord record;
+  memset(&record, 0, sizeof(record));
+  memcpy(&record, data, size < sizeof(record) ? size : sizeof(record));
+  game_data_apply((GameData*)context, &record);
+}
+
+// Version 8 clock records carried its play_clock, and its state records a
+// timer. The state only came from other watches and is dropped.
+static void game_data_replay_v8(void* context, const void* data, uint16_t size) {
+  GameRecord record;
+  memset(&record, 0, sizeof(record));
+  memcpy(&record, data, size < sizeof(record) ? size : sizeof(record));
+  if (record.type == RECORD_STATE) return;
+  if (record.type == RECORD_CLOCK) record.clock = record.clock ? CLOCK_PLAY : CLOCK_GAME;
+  game_data_apply((GameData*)context, &record);
+}
+
+static void game_data_record(GameData* data, const GameRecord* record, uint16_t size) {
+  game_data_apply(data, record);
+  // Fold the journal into a fresh snapshot once the ring is full
+  if (journal_append(&data->journal, record, size)) game_data_write(data, data->key);
+  if (data->listener) data->listener(data->listener_context, record, size);
+}
+
+static void game_data_announce_reset(GameData* data) {
+  GameRecord record = { .type = RECORD_RESET };
+  if (data->listener) data->listener(data->listener_context, &record, RECORD_HEADER);
+}
+
+static bool game_data_event(GameData* data, bool home, EventKind kind, uint8_t value) {
+  if (event_log_full(&data->events)) return false;
+  uint16_t seconds = game_data_clock_get_seconds(data, CLOCK_GAME);
+  GameRecord record = { .type = RECORD_EVENT };
+  record.payload.event = event_make(home, kind, value, data->quarter, seconds);
+  game_data_record(data, &record, RECORD_HEADER + sizeof(Event));
+  return true;
+}
+
+static void game_data_record_clock(GameData* data, ClockId clock) {
+  GameRecord record = { .type = RECORD_CLOCK, .clock = clock };
+  record.payload.timer = data->clocks[clock];
+  game_data_record(data, &record, RECORD_HEADER + sizeof(Timer));
+}
+
+// Rebuild the running totals after loading the log
+static void game_data_tally(GameData* data) {
+  team_data_clear_totals(&data->home);
+  team_data_clear_totals(&data->away);
+  for (uint16_t i = 0; i < event_log_size(&data->events); ++i) {
+    Event event = event_log_get(&data->events, i);
+    EventKind kind = event_kind(event);
+    if (kind == EVENT_SCORE || kind == EVENT_TRY) {
+      team_data_add_points(game_data_team(data, event_home(event)), event_quarter(event), event_value(event));
+    }
+  }
+}
+
+static void clock_follow(GameData* data, ClockId clock, bool was_running);
+
+static bool game_data_load(GameData* data, uint32_t key) {
+  data->key = key;
+  journal_init(&data->journal, key + JOURNAL_OFFSET, JOURNAL_SLOTS);
   GameDataStorage storage;
-  if (persist_read_data(key, &storage, sizeof(storage)) != sizeof(storage)) return false;
-  if (storage.version != STORAGE_VERSION) return false;
+  uint32_t version = game_data_storage_read(data, &storage, key);
+  if (!version) {
+    journal_skip(&data->journal);
+    return false;
+  }
   
-  data->timer = storage.timer;
+  memcpy(data->clocks, storage.clocks, sizeof(data->clocks));
   data->home.timeouts = storage.home_timeouts;
   data->away.timeouts = storage.away_timeouts;
   data->quarter = storage.quarter;
   data->try_active = storage.try_active;
   data->home_team_active = storage.home_team_active;
-  data->play_clock = storage.play_clock;
-  game_list_read(&data->home.scores, key + 1);
-  game_list_read(&data->away.scores, key + 2);
-  game_list_read(&data->home.penalties, key + 3);
-  game_list_read(&data->away.penalties, key + 4);
-  data->home.total = game_list_total_score(&data->home.scores);
-  data->away.total = game_list_total_score(&data->away.scores);
-  
-  if (data->timer.running) {
-    if (game_data_timer_get_value(data) == 0.0f) {
-      game_data_timer_stop(data);
-    } else {
-      game_data_timer_start(data);
-    }
-  } else {
-    game_data_timer_stop(data);
+  data->shown = storage.shown < CLOCK_COUNT ? storage.shown : CLOCK_GAME;
+  data->post_snap = storage.post_snap;
+  data->revision = storage.revision;
+  data->generation = storage.generation;
+  if (version == 4) {
+    event_log_clear(&data->events);
+    game_data_read_v4_list(data, key + 1, true, EVENT_SCORE);
+    game_data_read_v4_list(data, key + 2, false, EVENT_SCORE);
+    game_data_read_v4_list(data, key + 3, true, EVENT_PENALTY);
+    game_data_read_v4_list(data, key + 4, false, EVENT_PENALTY);
+  } else if (version != STORAGE_VERSION) {
+    event_log_read(&data->events, key + 1, EVENT_LOG_KEYS);
+  }
+  game_data_tally(data);
+  journal_replay(&data->journal, storage.journal_seq, version == 8 ? game_data_replay_v8 : game_data_replay, data);
+  if (data->journal.lapped) {
+    // Changes between the snapshot and the journal are gone, better a new
+    // game than an old one passed off as this one
+    APP_LOG(APP_LOG_LEVEL_ERROR, "Game lost, journal passed snapshot %u", storage.journal_seq);
+    journal_skip(&data->journal);
+    return false;
   }
+  
+  for (int i = 0; i < CLOCK_COUNT; ++i) clock_follow(data, i, data->clocks[i].running);
   return true;
 }
+
+bool game_data_read(GameData* data, uint32_t key) {
+  TRACE_BEGIN(TRACE_GAME_READ, 0);
+  bool found = game_data_load(data, key);
+  TRACE_END(TRACE_GAME_READ, found);
+  return found;
+}
+
 void game_data_write(GameData* data, uint32_t key) {
-  GameDataStorage storage = {
-    STORAGE_VERSION,
-    data->timer,
-    data->home.timeouts,
-    data->away.timeouts,
-    data->quarter,
-    data->try_active,
-    data->home_team_active,
-    data->play_clock
+  TRACE_BEGIN(TRACE_GAME_WRITE, 0);
+  Snapshot snapshot;
+  GameDataStorage* storage = &snapshot.storage;
+  uint16_t count = event_log_size(&data->events);
+  uint16_t in_record = snapshot_record_events(count);
+  *storage = (GameDataStorage) {
+    .version = STORAGE_VERSION,
+    .length = SNAPSHOT_COVERED + count * sizeof(Event),
+    .generation = data->generation + 1,
+    .event_count = count,
+    .home_timeouts = data->home.timeouts,
+    .away_timeouts = data->away.timeouts,
+    .quarter = data->quarter,
+    .try_active = data->try_active,
+    .home_team_active = data->home_team_active,
+    .shown = data->shown,
+    .post_snap = data->post_snap,
+    .journal_seq = journal_seq(&data->journal),
+    .revision = data->revision
   };
-  persist_write_data(key, &storage, sizeof(storage));
-  game_list_write(&data->home.scores, key + 1);
-  game_list_write(&data->away.scores, key + 2);
-  game_list_write(&data->home.penalties, key + 3);
-  game_list_write(&data->away.penalties, key + 4);
+  memcpy(storage->clocks, data->clocks, sizeof(storage->clocks));
+  memcpy(snapshot.events, data->events.data, in_record * sizeof(Event));
+  storage->crc = snapshot_crc(storage, data->events.data, count);
+  // Into the older bank, its record last so a cut short write fails the crc
+  uint32_t bank = key + (storage->generation % 2) * BANK_KEYS;
+  event_log_write(&data->events, in_record, bank + 1, EVENT_LOG_KEYS);
+  persist_write_data(bank, &snapshot, sizeof(GameDataStorage) + in_record * sizeof(Event));
+  activity_count(ACTIVITY_FLASH);
+  data->generation = storage->generation;
+  journal_compact(&data->journal);
+  TRACE_END(TRACE_GAME_WRITE, 0);
 }
-static double time_double() {
+static int32_t timer_elapsed_ms(Timer* timer) {
   time_t seconds;
   uint16_t milliseconds;
   time_ms(&seconds, &milliseconds);
-  return seconds + (double)milliseconds/1000.0;
+  int32_t elapsed = (int32_t)((uint32_t)seconds - timer->started) * 1000
+      + (int32_t)milliseconds - (int32_t)timer->started_ms;
+  // Wall clock moved backwards, treat as no time having passed
+  if (elapsed < 0) elapsed = 0;
+  return elapsed;
 }
 
-static void timer_handle(void* ctx) {
-  GameData* data = (GameData*)ctx;
-  data->timer_callbacks.timer = app_timer_register(100, timer_handle, ctx);
-  if (data->timer_callbacks.on_tick) data->timer_callbacks.on_tick(NULL);
-  if (game_data_timer_get_value(data) == 0.0) {
-    if (data->timer_callbacks.on_expire) data->timer_callbacks.on_expire(NULL);
-    game_data_timer_stop(data);
+// The display shows whole seconds rounded up, so a clock only changes when
+// its remaining time crosses an integer. Sleep until the first of the shown
+// clock and the game clock, which is always on screen, gets there.
+static void clock_schedule_tick(GameData* data) {
+  uint32_t next = UINT32_MAX;
+  ClockId visible[2] = { data->shown, CLOCK_GAME };
+  for (int i = 0; data->on_tick && i < 2; ++i) {
+    uint32_t value = game_data_clock_get_value(data, visible[i]);
+    // A clock at zero is stopped by its expiry
+    if (!data->clocks[visible[i]].running || value == 0) continue;
+    uint32_t ms = value % 1000;
+    if (ms == 0) ms = 1000;
+    if (ms < next) next = ms;
+  }
+  if (next == UINT32_MAX) {
+    deadlines_clear(&data->deadlines, DEADLINE_TICK);
+  } else {
+    deadlines_set_in(&data->deadlines, DEADLINE_TICK, next);
   }
 }
 
-void game_data_timer_start(GameData* data) {
-  if (!data->timer.running) {
-    data->timer.started = time_double();
-    data->timer.running = true;
+// The game warning is for the end of each half, not every quarter
+static bool quarter_ends_half(GameData* data) {
+  uint8_t half = app_config.periods / 2;
+  return data->quarter >= app_config.periods || (data->quarter + 1) % half == 0;
+}
+
+static uint16_t clock_warning(GameData* data, ClockId clock) {
+  switch (clock) {
+  case CLOCK_GAME: return quarter_ends_half(data) ? app_config.game_warning : 0;
+  case CLOCK_PLAY: return app_config.play_warning;
+  case CLOCK_BREAK: return app_config.break_warning;
+  default: return 0;
   }
-  if (!data->timer_callbacks.timer) {
-    data->timer_callbacks.timer = app_timer_register(100, timer_handle, data);
+}
+
+static void alerts_schedule_next(GameData* data) {
+  if (data->next_alert < data->alert_count) {
+    ClockAlert* alert = &data->alerts[data->next_alert];
+    deadlines_set(&data->deadlines, DEADLINE_ALERT, alert->seconds, alert->ms);
+  } else {
+    deadlines_clear(&data->deadlines, DEADLINE_ALERT);
   }
-  if (data->timer_callbacks.on_start) data->timer_callbacks.on_start(NULL);
 }
-void game_data_timer_stop(GameData* data) {
-  if (data->timer.running) {
-    data->timer.initial = game_data_timer_get_value(data);
-    data->timer.running = false;
+
+// Lay out the warnings still ahead on the running clocks. Each is at an
+// exact offset from its clock's deadline, so nothing is checked per tick.
+static void alerts_compile(GameData* data) {
+  data->alert_count = 0;
+  data->next_alert = 0;
+  for (int i = 0; i < CLOCK_COUNT; ++i) {
+    uint16_t warning = clock_warning(data, i);
+    ClockAlert alert = { .clock = i };
+    if (!warning || game_data_clock_get_value(data, i) <= warning * 1000u
+        || !game_data_clock_deadline(data, i, &alert.seconds, &alert.ms)) {
+      continue;
+    }
+    alert.seconds -= warning;
+    // Insertion sort, there is at most one per clock
+    uint8_t position = data->alert_count++;
+    while (position > 0) {
+      ClockAlert* before = &data->alerts[position - 1];
+      int32_t difference = (int32_t)(before->seconds - alert.seconds);
+      if (difference < 0 || (difference == 0 && before->ms <= alert.ms)) break;
+      data->alerts[position] = *before;
+      --position;
+    }
+    data->alerts[position] = alert;
   }
-  if (data->timer_callbacks.timer) {
-    app_timer_cancel(data->timer_callbacks.timer);
-    data->timer_callbacks.timer = NULL;
+  alerts_schedule_next(data);
+}
+
+// Move the clock's expiry to match its timer
+static void clock_schedule(GameData* data, ClockId clock) {
+  uint32_t seconds;
+  uint16_t milliseconds;
+  if (game_data_clock_deadline(data, clock, &seconds, &milliseconds)) {
+    deadlines_set(&data->deadlines, clock, seconds, milliseconds);
+  } else {
+    deadlines_clear(&data->deadlines, clock);
   }
-  if (data->timer_callbacks.on_stop) data->timer_callbacks.on_stop(NULL);
+  clock_schedule_tick(data);
+  alerts_compile(data);
 }
-void game_data_timer_reset(GameData* data) {
-  if (game_data_timer_is_running(data)) game_data_timer_stop(data);
-  data->timer.initial = data->timer.reset_to;
-  if (data->timer_callbacks.on_tick) data->timer_callbacks.on_tick(NULL);
+
+static void clock_halt(GameData* data, ClockId clock) {
+  Timer* timer = &data->clocks[clock];
+  if (timer->running) {
+    timer->initial = game_data_clock_get_value(data, clock);
+    timer->running = false;
+  }
+  clock_schedule(data, clock);
 }
 
-void game_data_timer_set_reset(GameData* data, uint16_t value) {
-  data->timer.reset_to = value;
+static void clock_expire(GameData* data, ClockId clock) {
+  if (data->on_tick) data->on_tick(NULL);
+  if (data->clock_callbacks[clock].on_expire) data->clock_callbacks[clock].on_expire(clock);
+  // Every watch runs out at the same moment, so the stop is not sent. A
+  // late copy would otherwise stop a clock another watch has since reset.
+  GameDataListener listener = data->listener;
+  data->listener = NULL;
+  game_data_clock_stop(data, clock);
+  data->listener = listener;
 }
 
-double game_data_timer_get_value(GameData* data) {
-  if (data->timer.running) {
-    double current = time_double();
-    double total_seconds = data->timer.started - current + data->timer.initial;
-    if (total_seconds < 0) total_seconds = 0.0;
-    return total_seconds;
+static void game_data_deadline(void* context, uint8_t id) {
+  GameData* data = (GameData*)context;
+  if (id == DEADLINE_TICK) {
+    if (data->on_tick) data->on_tick(NULL);
+    clock_schedule_tick(data);
+  } else if (id == DEADLINE_ALERT && data->next_alert < data->alert_count) {
+    ClockId clock = data->alerts[data->next_alert++].clock;
+    alerts_schedule_next(data);
+    if (data->clock_callbacks[clock].on_warning) data->clock_callbacks[clock].on_warning(clock);
+  } else if (id < CLOCK_COUNT) {
+    clock_expire(data, id);
+  }
+}
+
+void game_data_clock_start(GameData* data, ClockId clock) {
+  Timer* timer = &data->clocks[clock];
+  if (!timer->running) {
+    time_t seconds;
+    time_ms(&seconds, &timer->started_ms);
+    timer->started = (uint32_t)seconds;
+    timer->running = true;
+  }
+  // Restarting changes the phase of the second boundaries
+  clock_schedule(data, clock);
+  game_data_record_clock(data, clock);
+  if (data->clock_callbacks[clock].on_start) data->clock_callbacks[clock].on_start(clock);
+}
+void game_data_clock_stop(GameData* data, ClockId clock) {
+  clock_halt(data, clock);
+  game_data_record_clock(data, clock);
+  if (data->clock_callbacks[clock].on_stop) data->clock_callbacks[clock].on_stop(clock);
+}
+void game_data_clock_reset(GameData* data, ClockId clock) {
+  if (game_data_clock_is_running(data, clock)) {
+    clock_halt(data, clock);
+    if (data->clock_callbacks[clock].on_stop) data->clock_callbacks[clock].on_stop(clock);
+  }
+  data->clocks[clock].initial = data->clocks[clock].reset_to * 1000;
+  game_data_record_clock(data, clock);
+  if (data->on_tick) data->on_tick(NULL);
+}
+
+void game_data_clock_set_reset(GameData* data, ClockId clock, uint16_t value) {
+  data->clocks[clock].reset_to = value;
+}
+
+uint32_t game_data_clock_get_value(GameData* data, ClockId clock) {
+  Timer* timer = &data->clocks[clock];
+  if (timer->running) {
+    int32_t elapsed = timer_elapsed_ms(timer);
+    if ((uint32_t)elapsed >= timer->initial) return 0;
+    return timer->initial - elapsed;
   } else {
-    return (uint16_t) data->timer.initial;
+    return timer->initial;
   }
 }
 
-void game_data_timer_set_callbacks(GameData* data, 
-          TimerCallback start, TimerCallback stop, TimerCallback tick, TimerCallback expire) {
-  data->timer_callbacks.on_start = start;
-  data->timer_callbacks.on_stop = stop;
-  data->timer_callbacks.on_tick = tick;
-  data->timer_callbacks.on_expire = expire;
-  
-  if (data->timer.running) {
-    if (data->timer_callbacks.on_start) data->timer_callbacks.on_start(NULL);
+uint16_t game_data_clock_get_seconds(GameData* data, ClockId clock) {
+  return (game_data_clock_get_value(data, clock) + 999) / 1000;
+}
+
+bool game_data_clock_is_running(GameData* data, ClockId clock) {
+  return data->clocks[clock].running;
+}
+
+bool game_data_clock_deadline(GameData* data, ClockId clock, uint32_t* seconds, uint16_t* milliseconds) {
+  Timer* timer = &data->clocks[clock];
+  if (!timer->running) return false;
+  uint32_t end_ms = timer->started_ms + timer->initial;
+  *seconds = timer->started + end_ms / 1000;
+  *milliseconds = end_ms % 1000;
+  return true;
+}
+
+void game_data_clock_set_callbacks(GameData* data, ClockId clock, ClockCallbacks callbacks) {
+  data->clock_callbacks[clock] = callbacks;
+  if (data->clocks[clock].running) {
+    if (callbacks.on_start) callbacks.on_start(clock);
   } else {
-    if (data->timer_callbacks.on_stop) data->timer_callbacks.on_stop(NULL);
+    if (callbacks.on_stop) callbacks.on_stop(clock);
   }
-  if (data->timer_callbacks.on_tick) data->timer_callbacks.on_tick(NULL);
 }
 
-bool game_data_timer_is_running(GameData* data) {
-  return data->timer.running;
+void game_data_set_tick_callback(GameData* data, TimerCallback tick) {
+  data->on_tick = tick;
+  clock_schedule_tick(data);
+  if (tick) tick(NULL);
 }
 
-void team_data_new_score(TeamData* data, uint8_t score, uint8_t quarter, uint8_t time) {
-  data->total += score;
-  game_list_add(&data->scores, score, quarter, time);
+void game_data_clock_show(GameData* data, ClockId clock) {
+  data->shown = clock;
+  clock_schedule_tick(data);
+  if (data->on_tick) data->on_tick(NULL);
 }
-void team_data_add_pat(TeamData* data, uint8_t score) {
-  data->total += score;
-  game_list_amend_last(&data->scores, score + 6);
+
+bool game_data_add_score(GameData* data, bool home, uint8_t points) {
+  return game_data_event(data, home, EVENT_SCORE, points);
+}
+bool game_data_add_try(GameData* data, uint8_t points) {
+  return game_data_event(data, data->home_team_active, EVENT_TRY, points);
+}
+bool game_data_add_penalty(GameData* data, bool home, uint8_t number) {
+  return game_data_event(data, home, EVENT_PENALTY, number);
+}
+bool game_data_add_timeout(GameData* data, bool home) {
+  if (game_data_team(data, home)->timeouts == 0) return false;
+  return game_data_event(data, home, EVENT_TIMEOUT, 0);
+}
+
+typedef struct ShortcutEvent_t {
+  uint8_t kind;
+  bool home;
+  uint8_t value;
+} ShortcutEvent;
+
+static const ShortcutEvent s_shortcuts[SHORTCUT_COUNT] = {
+  [SHORTCUT_HOME_TOUCHDOWN] = { EVENT_SCORE, true, 6 },
+  [SHORTCUT_AWAY_TOUCHDOWN] = { EVENT_SCORE, false, 6 },
+  [SHORTCUT_HOME_FIELD_GOAL] = { EVENT_SCORE, true, 3 },
+  [SHORTCUT_AWAY_FIELD_GOAL] = { EVENT_SCORE, false, 3 },
+  [SHORTCUT_HOME_SAFETY] = { EVENT_SCORE, true, 2 },
+  [SHORTCUT_AWAY_SAFETY] = { EVENT_SCORE, false, 2 },
+  [SHORTCUT_TRY_2] = { EVENT_TRY, false, 2 },
+  [SHORTCUT_TRY_1] = { EVENT_TRY, false, 1 },
+  [SHORTCUT_TRY_FAILED] = { EVENT_TRY, false, 0 },
+  [SHORTCUT_HOME_TIMEOUT] = { EVENT_TIMEOUT, true, 0 },
+  [SHORTCUT_AWAY_TIMEOUT] = { EVENT_TIMEOUT, false, 0 }
+};
+
+bool game_data_shortcut(GameData* data, uint8_t shortcut) {
+  if (shortcut == SHORTCUT_NONE || shortcut >= SHORTCUT_COUNT) return false;
+  const ShortcutEvent* event = &s_shortcuts[shortcut];
+  switch (event->kind) {
+  case EVENT_SCORE:
+    if (data->try_active) return false;
+    return game_data_add_score(data, event->home, event->value);
+  case EVENT_TRY:
+    if (!data->try_active) return false;
+    return game_data_add_try(data, event->value);
+  default:
+    return game_data_add_timeout(data, event->home);
+  }
+}
+void game_data_end_quarter(GameData* data) {
+  GameRecord record = { .type = RECORD_QUARTER };
+  game_data_record(data, &record, RECORD_HEADER);
+  game_data_clock_set_reset(data, CLOCK_GAME, app_config.game_clock);
+  game_data_clock_reset(data, CLOCK_GAME);
+}
+bool game_data_undo(GameData* data) {
+  if (event_log_empty(&data->events)) return false;
+  GameRecord record = { .type = RECORD_UNDO };
+  game_data_record(data, &record, RECORD_HEADER);
+  return true;
+}
+void game_data_set_listener(GameData* data, GameDataListener listener, void* context) {
+  data->listener = listener;
+  data->listener_context = context;
+}
+
+// Bring the deadlines and display in line with a clock set from elsewhere
+static void clock_follow(GameData* data, ClockId clock, bool was_running) {
+  Timer* timer = &data->clocks[clock];
+  if (timer->running && game_data_clock_get_value(data, clock) == 0) {
+    clock_halt(data, clock);
+  } else {
+    clock_schedule(data, clock);
+  }
+  ClockCallbacks* callbacks = &data->clock_callbacks[clock];
+  if (timer->running && !was_running) {
+    if (callbacks->on_start) callbacks->on_start(clock);
+  } else if (!timer->running && was_running) {
+    if (callbacks->on_stop) callbacks->on_stop(clock);
+  }
+  if (data->on_tick) data->on_tick(NULL);
+}
+
+void game_data_apply_remote(GameData* data, const void* bytes, uint16_t size) {
+  GameRecord record;
+  memset(&record, 0, sizeof(record));
+  memcpy(&record, bytes, size < sizeof(record) ? size : sizeof(record));
+  GameDataListener listener = data->listener;
+  data->listener = NULL;
+  if (record.type == RECORD_RESET) {
+    game_data_reset(data);
+  } else if (record.type == RECORD_CLOCK) {
+    if (record.clock < CLOCK_COUNT) {
+      bool was_running = data->clocks[record.clock].running;
+      game_data_record(data, &record, size);
+      clock_follow(data, record.clock, was_running);
+    }
+  } else if (record.type <= RECORD_STATE) {
+    game_data_record(data, &record, size);
+  }
+  data->listener = listener;
+}
+
+uint16_t game_data_export(GameData* data, uint16_t index, void* bytes) {
+  uint16_t events = event_log_size(&data->events);
+  GameRecord record;
+  memset(&record, 0, sizeof(record));
+  uint16_t size = RECORD_HEADER;
+  if (index == 0) {
+    record.type = RECORD_RESET;
+  } else if (index <= events) {
+    record.type = RECORD_EVENT;
+    record.payload.event = event_log_get(&data->events, index - 1);
+    size += sizeof(Event);
+  } else if (index <= events + CLOCK_COUNT) {
+    record.type = RECORD_CLOCK;
+    record.clock = index - events - 1;
+    record.payload.timer = data->clocks[record.clock];
+    size += sizeof(Timer);
+  } else if (index == events + CLOCK_COUNT + 1) {
+    // Applying the events moved timeouts and the try, this puts them back
+    record.type = RECORD_STATE;
+    record.payload.state = (GameState) {
+      .quarter = data->quarter,
+      .home_timeouts = data->home.timeouts,
+      .away_timeouts = data->away.timeouts,
+      .try_active = data->try_active,
+      .home_team_active = data->home_team_active,
+      .revision = data->revision
+    };
+    size += sizeof(GameState);
+  } else {
+    return 0;
+  }
+  memcpy(bytes, &record, size);
+  return size;
+}
+
+uint16_t game_data_revision(GameData* data) {
+  return data->revision;
 }
\ No newline at end of file
@@ -1,33 +1,60 @@
 #pragma once
-#include "GameList.h"
+#include "EventLog.h"
+#include "Journal.h"
+#include "Deadlines.h"
 
 typedef struct TeamData_t {
-  GameList scores;
-  GameList penalties;
   uint16_t total;
   uint8_t timeouts;
+  // Running totals by quarter_index() and quarter_half(), overtime is only
+  // counted in period_totals
+  uint16_t period_totals[PERIODS_MAX + 1];
+  uint16_t half_totals[2];
 } TeamData;
   
+// Times are integer milliseconds, the start is the raw time_ms() reading
 typedef struct Timer_t {
-  double initial;
-  double started;
+  uint32_t initial;
+  uint32_t started;
+  uint16_t started_ms;
   bool running;
   uint16_t reset_to;
 } Timer;
 
+// Clocks that run side by side. The break clock is used for timeouts and
+// half time.
+typedef enum {
+  CLOCK_GAME,
+  CLOCK_PLAY,
+  CLOCK_BREAK,
+  CLOCK_COUNT
+} ClockId;
+
 typedef void (*TimerCallback)(void*);
-typedef struct TimerInternal_t {
-  TimerCallback on_start;
-  TimerCallback on_stop;
-  TimerCallback on_tick;
-  TimerCallback on_expire;
-  AppTimer* timer;
-} TimerInternal;
+typedef void (*ClockCallback)(ClockId clock);
+typedef struct ClockCallbacks_t {
+  ClockCallback on_start;
+  ClockCallback on_stop;
+  // The clock is down to its warning time from AppConfig
+  ClockCallback on_warning;
+  ClockCallback on_expire;
+} ClockCallbacks;
+
+// A warning still to come, at a time_ms() reading
+typedef struct ClockAlert_t {
+  uint32_t seconds;
+  uint16_t ms;
+  uint8_t clock;
+} ClockAlert;
+
+// Told about every change to the game, in the journal's record format
+typedef void (*GameDataListener)(void* context, const void* record, uint16_t size);
 
 typedef struct GameData_t {
   // Team information
   TeamData home;
   TeamData away;
+  EventLog events;
   
   // Runtime information
   bool home_team_active;
@@ -36,16 +63,37 @@ typedef struct GameData_t {
   // Timer information
   uint8_t quarter;
   
-  Timer timer;
-  TimerInternal timer_callbacks;
+  Timer clocks[CLOCK_COUNT];
+  ClockCallbacks clock_callbacks[CLOCK_COUNT];
+  // Called when the shown clock or the game clock changes second
+  TimerCallback on_tick;
+  // Expiry of each clock by ClockId, then the next tick and alert
+  Deadlines deadlines;
+  // Warnings for the running clocks, soonest first. Rebuilt whenever a
+  // clock starts or stops, and only the next one is held in deadlines.
+  ClockAlert alerts[CLOCK_COUNT];
+  uint8_t alert_count;
+  uint8_t next_alert;
+  
+  // Which clock this watch shows and the bottom button controls, and
+  // whether the play clock has moved on to the post-snap time. Neither is
+  // shared with other watches.
+  uint8_t shown;
+  bool post_snap;
   
-  uint8_t play_clock;
+  // Snapshot key set by game_data_read, changes since are journaled
+  uint32_t key;
+  // Of the last snapshot read or written, which picks the bank for the next
+  uint16_t generation;
+  Journal journal;
+  // Changes made to the game so far, the same on every watch that has seen
+  // the same changes
+  uint16_t revision;
   
+  GameDataListener listener;
+  void* listener_context;
 } GameData;
 
-static const int SCORE_OFFSET = offsetof(TeamData, scores);
-static const int PENALTY_OFFSET = offsetof(TeamData, penalties);
-
 void game_data_init(GameData* data);
 void game_data_free(GameData* data);
 void game_data_reset(GameData* data);
@@ -53,19 +101,43 @@ void game_data_reset(GameData* data);
 bool game_data_read(GameData* data, uint32_t key);
 void game_data_write(GameData* data, uint32_t key);
 
-void game_data_timer_start(GameData* data);
-void game_data_timer_stop(GameData* data);
-void game_data_timer_reset(GameData* data);
+void game_data_clock_start(GameData* data, ClockId clock);
+void game_data_clock_stop(GameData* data, ClockId clock);
+void game_data_clock_reset(GameData* data, ClockId clock);
 
-void game_data_timer_set_reset(GameData* data, uint16_t value);
-double game_data_timer_get_value(GameData* data);
-void game_data_timer_set_callbacks(GameData* data, 
-          TimerCallback start, TimerCallback stop, TimerCallback tick, TimerCallback expire);
-bool game_data_timer_is_running(GameData* data);
+void game_data_clock_set_reset(GameData* data, ClockId clock, uint16_t value);
+uint32_t game_data_clock_get_value(GameData* data, ClockId clock);
+uint16_t game_data_clock_get_seconds(GameData* data, ClockId clock);
+bool game_data_clock_is_running(GameData* data, ClockId clock);
+// Wall time the running clock reaches zero, in time_ms() form. False if
+// the clock is stopped.
+bool game_data_clock_deadline(GameData* data, ClockId clock, uint32_t* seconds, uint16_t* milliseconds);
+void game_data_clock_set_callbacks(GameData* data, ClockId clock, ClockCallbacks callbacks);
+void game_data_set_tick_callback(GameData* data, TimerCallback tick);
+void game_data_clock_show(GameData* data, ClockId clock);
 
-void team_data_new_score(TeamData* data, uint8_t score, uint8_t quarter, uint8_t time);
-void team_data_add_pat(TeamData* data, uint8_t score);
+// Game events, each is journaled so it survives the app being killed.
+// They return false without changing anything once the event log is full,
+// or for a timeout when the team has none left.
+bool game_data_add_score(GameData* data, bool home, uint8_t points);
+bool game_data_add_try(GameData* data, uint8_t points);
+bool game_data_add_penalty(GameData* data, bool home, uint8_t number);
+bool game_data_add_timeout(GameData* data, bool home);
+// The event a Shortcut stands for. As in the menus a try has to follow a
+// touchdown and come before the next score, false otherwise.
+bool game_data_shortcut(GameData* data, uint8_t shortcut);
+// Also resets the game clock for the next quarter
+void game_data_end_quarter(GameData* data);
+// Removes the last score, try, penalty or timeout, false if there was none
+bool game_data_undo(GameData* data);
 
-void team_data_add_penalty(TeamData* data, uint8_t number, uint8_t quarter, uint8_t time);
-void team_data_add_timeout(TeamData* data, uint8_t number, uint8_t quarter, uint8_t time);
+// Mirroring the game on other watches. Changes applied with apply_remote
+// are not passed back to the listener.
+void game_data_set_listener(GameData* data, GameDataListener listener, void* context);
+void game_data_apply_remote(GameData* data, const void* record, uint16_t size);
+// Records that rebuild the whole game when applied in order from index 0.
+// Writes at most JOURNAL_RECORD_MAX bytes, returns 0 past the last one.
+uint16_t game_data_export(GameData* data, uint16_t index, void* record);
+// Number of changes this copy of the game has seen
+uint16_t game_data_revision(GameData* data);
 
@@ -0,0 +1,73 @@
+#include <pebble.h>
+#include "HeapStats.h"
+#include "Activity.h"
+
+#define HEAP_STATS_KEY 101
+#define HEAP_STATS_VERSION 1
+
+HeapStats heap_stats;
+// Bytes charged to subsystems since launch
+static int32_t s_charged;
+// A peak has moved since the stats were last in flash
+static bool s_dirty;
+
+void heap_stats_sample() {
+  uint32_t used = heap_bytes_used();
+  uint32_t available = heap_bytes_free();
+  if (used > heap_stats.used_peak) {
+    heap_stats.used_peak = used;
+    s_dirty = true;
+  }
+  if (available < heap_stats.free_low) {
+    heap_stats.free_low = available;
+    s_dirty = true;
+  }
+}
+
+void heap_stats_reset() {
+  heap_stats.version = HEAP_STATS_VERSION;
+  for (int i = 0; i < HEAP_SUBSYSTEM_COUNT; ++i) {
+    heap_stats.subsystems[i].peak = heap_stats.subsystems[i].current;
+  }
+  heap_stats.used_peak = 0;
+  heap_stats.free_low = UINT32_MAX;
+  s_dirty = true;
+  heap_stats_sample();
+}
+
+void heap_stats_init() {
+  s_charged = 0;
+  if (persist_read_data(HEAP_STATS_KEY, &heap_stats, sizeof(heap_stats)) == sizeof(heap_stats)
+      && heap_stats.version == HEAP_STATS_VERSION) {
+    for (int i = 0; i < HEAP_SUBSYSTEM_COUNT; ++i) heap_stats.subsystems[i].current = 0;
+    s_dirty = false;
+    heap_stats_sample();
+  } else {
+    memset(&heap_stats, 0, sizeof(heap_stats));
+    heap_stats_reset();
+  }
+}
+
+void heap_stats_write() {
+  if (!s_dirty) return;
+  persist_write_data(HEAP_STATS_KEY, &heap_stats, sizeof(heap_stats));
+  activity_count(ACTIVITY_FLASH);
+  s_dirty = false;
+}
+
+// What is in use and not yet charged to anyone
+int32_t heap_stats_mark() {
+  return (int32_t)heap_bytes_used() - s_charged;
+}
+
+void heap_stats_charge(HeapSubsystem subsystem, int32_t mark) {
+  HeapUsage* usage = &heap_stats.subsystems[subsystem];
+  int32_t bytes = heap_stats_mark() - mark;
+  s_charged += bytes;
+  usage->current += bytes;
+  if (usage->current > usage->peak) {
+    usage->peak = usage->current;
+    s_dirty = true;
+  }
+  heap_stats_sample();
+}
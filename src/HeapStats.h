@@ -0,0 +1,44 @@
+#pragma once
+#include <pebble.h>
+
+// Where the app heap goes, by the part of the app that asked for it. Most
+// of it is allocated by the SDK on our behalf, so each subsystem is charged
+// the change in heap_bytes_used() across the calls it makes.
+typedef enum {
+  HEAP_WINDOWS,
+  HEAP_LAYERS,
+  // Menu and choice layers, including the list views
+  HEAP_MENUS,
+  // AppMessage inbox and outbox
+  HEAP_MESSAGES,
+  HEAP_SUBSYSTEM_COUNT
+} HeapSubsystem;
+
+typedef struct HeapUsage_t {
+  int32_t current;
+  int32_t peak;
+} HeapUsage;
+
+// Peaks cover the whole game across launches and are kept in flash, so
+// they can be read after the game. Current values start again each launch.
+typedef struct HeapStats_t {
+  uint16_t version;
+  HeapUsage subsystems[HEAP_SUBSYSTEM_COUNT];
+  // The whole heap, including anything not charged to a subsystem
+  uint32_t used_peak;
+  uint32_t free_low;
+} HeapStats;
+
+extern HeapStats heap_stats;
+
+void heap_stats_init();
+void heap_stats_write();
+// A new game, the peaks start again from what is in use now
+void heap_stats_reset();
+
+// Take a mark before allocating or freeing, then charge the difference.
+// Marks nest, anything charged in between is not charged again.
+int32_t heap_stats_mark();
+void heap_stats_charge(HeapSubsystem subsystem, int32_t mark);
+// Updates the whole heap peak and low water without charging anyone
+void heap_stats_sample();
@@ -0,0 +1,74 @@
+#include <pebble.h>
+#include "Journal.h"
+#include "Activity.h"
+
+typedef struct JournalEntry_t {
+  uint16_t seq;
+  uint8_t data[JOURNAL_RECORD_MAX];
+} JournalEntry;
+
+static const int ENTRY_HEADER = offsetof(JournalEntry, data);
+
+void journal_init(Journal* journal, uint32_t key, uint8_t slots) {
+  journal->key = key;
+  journal->slots = slots;
+  journal->base = 0;
+  journal->seq = 0;
+  journal->lapped = false;
+}
+
+void journal_compact(Journal* journal) {
+  journal->base = journal->seq;
+}
+
+void journal_skip(Journal* journal) {
+  JournalEntry entry;
+  bool found = false;
+  for (uint8_t i = 0; i < journal->slots; ++i) {
+    int size = persist_read_data(journal->key + i, &entry, sizeof(entry));
+    if (size < ENTRY_HEADER) continue;
+    if (!found || (int16_t)(entry.seq - journal->seq) > 0) journal->seq = entry.seq;
+    found = true;
+  }
+  journal->base = journal->seq;
+}
+
+uint16_t journal_seq(Journal* journal) {
+  return journal->seq;
+}
+
+static uint32_t journal_key(Journal* journal, uint16_t seq) {
+  return journal->key + seq % journal->slots;
+}
+
+bool journal_append(Journal* journal, const void* record, uint16_t size) {
+  JournalEntry entry;
+  if (size > JOURNAL_RECORD_MAX) size = JOURNAL_RECORD_MAX;
+  entry.seq = ++journal->seq;
+  memcpy(entry.data, record, size);
+  persist_write_data(journal_key(journal, entry.seq), &entry, ENTRY_HEADER + size);
+  activity_count(ACTIVITY_FLASH);
+  return (uint16_t)(journal->seq - journal->base) >= journal->slots;
+}
+
+uint16_t journal_replay(Journal* journal, uint16_t base, JournalCallback callback, void* context) {
+  JournalEntry entry;
+  uint16_t count = 0;
+  journal->base = base;
+  journal->seq = base;
+  journal->lapped = false;
+  while (count < journal->slots) {
+    uint16_t expected = base + count + 1;
+    int size = persist_read_data(journal_key(journal, expected), &entry, sizeof(entry));
+    if (size < ENTRY_HEADER) break;
+    if (entry.seq != expected) {
+      // A later record in the slot means the ones after base were overwritten
+      journal->lapped = (int16_t)(entry.seq - expected) > 0;
+      break;
+    }
+    callback(context, entry.data, size - ENTRY_HEADER);
+    journal->seq = expected;
+    ++count;
+  }
+  return count;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <pebble.h>
+
+// Append-only log of small records spread over a ring of persist keys, one
+// record per key. Each record carries a sequence number so that on replay
+// entries already folded into a snapshot can be told apart from new ones.
+typedef struct Journal_t {
+  uint32_t key;
+  uint8_t slots;
+  // Sequence number covered by the last snapshot and the last one written
+  uint16_t base;
+  uint16_t seq;
+  // Replay found the ring had moved past the snapshot, records are missing
+  bool lapped;
+} Journal;
+
+#define JOURNAL_RECORD_MAX 32
+
+typedef void (*JournalCallback)(void* context, const void* record, uint16_t size);
+
+void journal_init(Journal* journal, uint32_t key, uint8_t slots);
+
+// Number new records after every one left in the ring, for a journal whose
+// snapshot was lost so that stale records are not taken for lost ones later
+void journal_skip(Journal* journal);
+// Mark everything written so far as covered by a snapshot
+void journal_compact(Journal* journal);
+uint16_t journal_seq(Journal* journal);
+
+// Returns true once the ring is full and a snapshot must be taken
+bool journal_append(Journal* journal, const void* record, uint16_t size);
+// Feed every record written after the snapshot at base to the callback
+uint16_t journal_replay(Journal* journal, uint16_t base, JournalCallback callback, void* context);
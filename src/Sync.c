@@ -0,0 +1,345 @@
+#include <pebble.h>
+#include "Sync.h"
+#include "Activity.h"
+
+// Every frame starts with the kind, the sender's id and two words, all
+// little endian.
+//   FRAME_DELTAS  seq, sender's revision after it, then records each
+//                 prefixed with their size
+//   FRAME_EXPORT  as FRAME_DELTAS, starts a whole-game export
+//   FRAME_RESEND  peer id, first seq wanted again from that peer
+//   FRAME_RESYNC  peer id or SYNC_BROADCAST, revision of the watch asking
+//                 for the whole game
+//   FRAME_TAIL    seq of the next frame, sender's revision
+typedef enum {
+  FRAME_DELTAS,
+  FRAME_EXPORT,
+  FRAME_RESEND,
+  FRAME_RESYNC,
+  FRAME_TAIL
+} FrameKind;
+
+#define FRAME_HEADER 7
+#define PENDING_MAX (SYNC_FRAME_MAX - FRAME_HEADER)
+
+// Long enough to catch a score and its try, or a stop and a reset
+static const uint32_t SYNC_COALESCE_MS = 250;
+// Quiet time before the last seq is repeated, doubling for each repeat
+static const uint32_t SYNC_TAIL_MS = 30000;
+static const uint8_t SYNC_TAILS = 3;
+static const uint32_t SYNC_RETRY_MS = 1000;
+static const uint8_t SYNC_RETRY_MAX_SHIFT = 5;
+// Out of order frames to let through before asking for a resend again
+static const uint8_t SYNC_RESEND_EVERY = 4;
+
+static void put_u16(uint8_t* data, uint16_t value) {
+  data[0] = value & 0xFF;
+  data[1] = value >> 8;
+}
+
+static uint16_t get_u16(const uint8_t* data) {
+  return data[0] | (data[1] << 8);
+}
+
+static void sync_header(Sync* sync, uint8_t* data, FrameKind kind, uint16_t first, uint16_t second) {
+  data[0] = kind;
+  put_u16(data + 1, sync->id);
+  put_u16(data + 3, first);
+  put_u16(data + 5, second);
+}
+
+static void sync_pump(Sync* sync);
+
+static void sync_timer_handle(void* context) {
+  Sync* sync = (Sync*)context;
+  activity_count(ACTIVITY_WAKEUP);
+  sync->flush_timer = NULL;
+  sync_flush(sync);
+}
+
+static void sync_schedule(Sync* sync, uint32_t ms) {
+  if (!sync->flush_timer) sync->flush_timer = app_timer_register(ms, sync_timer_handle, sync);
+}
+
+static void sync_request(Sync* sync, FrameKind kind, uint16_t first, uint16_t second) {
+  sync_header(sync, sync->control, kind, first, second);
+  sync->control_size = FRAME_HEADER;
+  sync_pump(sync);
+}
+
+static void sync_tail_handle(void* context) {
+  Sync* sync = (Sync*)context;
+  activity_count(ACTIVITY_WAKEUP);
+  sync->tail_timer = NULL;
+  // A frame is on its way and sets off the tail again
+  if (sync->pending_size || sync->sent != sync->seq || sync->resync) return;
+  sync_request(sync, FRAME_TAIL, sync->seq, game_data_revision(sync->game));
+  if (++sync->tails < SYNC_TAILS) {
+    sync->tail_timer = app_timer_register(SYNC_TAIL_MS << sync->tails, sync_tail_handle, sync);
+  }
+}
+
+// Turn the pending records into the next frame of the ring
+static void sync_build(Sync* sync, FrameKind kind) {
+  if (!sync->pending_size) return;
+  // Never overwrite a frame that has not gone out, peers will see the gap
+  if ((uint16_t)(sync->seq - sync->sent) >= SYNC_HISTORY) sync->sent = sync->seq - SYNC_HISTORY + 1;
+  SyncFrame* frame = &sync->history[sync->seq % SYNC_HISTORY];
+  frame->seq = sync->seq;
+  sync_header(sync, frame->data, kind, sync->seq, game_data_revision(sync->game));
+  memcpy(frame->data + FRAME_HEADER, sync->pending, sync->pending_size);
+  frame->size = FRAME_HEADER + sync->pending_size;
+  sync->pending_size = 0;
+  sync->seq++;
+  if (sync->held < SYNC_HISTORY) sync->held++;
+}
+
+static bool sync_append(Sync* sync, const void* record, uint16_t size) {
+  if (sync->pending_size + 1 + size > PENDING_MAX) return false;
+  sync->pending[sync->pending_size] = size;
+  memcpy(sync->pending + sync->pending_size + 1, record, size);
+  sync->pending_size += 1 + size;
+  return true;
+}
+
+// Fill one frame with the next part of the whole-game export
+static void sync_resync_fill(Sync* sync) {
+  uint8_t record[JOURNAL_RECORD_MAX];
+  FrameKind kind = sync->resync == 1 ? FRAME_EXPORT : FRAME_DELTAS;
+  while (sync->resync) {
+    uint16_t size = game_data_export(sync->game, sync->resync - 1, record);
+    if (!size) {
+      sync->resync = 0;
+    } else if (sync_append(sync, record, size)) {
+      sync->resync++;
+    } else {
+      break;
+    }
+  }
+  sync_build(sync, kind);
+}
+
+static void sync_start_resync(Sync* sync) {
+  sync_build(sync, FRAME_DELTAS);
+  sync->resync = 1;
+  sync->stats.resyncs_sent++;
+  sync_pump(sync);
+}
+
+static void sync_pump(Sync* sync) {
+  while (!sync->busy) {
+    if (sync->control_size) {
+      if (!sync->send(sync->send_context, sync->control, sync->control_size)) return;
+      sync->in_flight_frame = false;
+      sync->stats.bytes_sent += sync->control_size;
+      sync->control_size = 0;
+    } else if (sync->sent != sync->seq) {
+      SyncFrame* frame = &sync->history[sync->sent % SYNC_HISTORY];
+      if (!sync->send(sync->send_context, frame->data, frame->size)) return;
+      sync->in_flight_frame = true;
+      sync->in_flight = sync->sent++;
+      sync->stats.bytes_sent += frame->size;
+      sync->tails = 0;
+      if (sync->tail_timer) {
+        app_timer_reschedule(sync->tail_timer, SYNC_TAIL_MS);
+      } else {
+        sync->tail_timer = app_timer_register(SYNC_TAIL_MS, sync_tail_handle, sync);
+      }
+    } else if (sync->resync) {
+      sync_resync_fill(sync);
+      continue;
+    } else {
+      return;
+    }
+    sync->busy = true;
+    sync->stats.frames_sent++;
+  }
+}
+
+// Every change made on this watch is queued for the others
+static void sync_changed(void* context, const void* record, uint16_t size) {
+  Sync* sync = (Sync*)context;
+  // The export is read from the live game, start it over to take this in
+  if (sync->resync) {
+    sync->resync = 1;
+    return;
+  }
+  if (!sync_append(sync, record, size)) {
+    sync_build(sync, FRAME_DELTAS);
+    sync_append(sync, record, size);
+  }
+  sync_schedule(sync, SYNC_COALESCE_MS);
+}
+
+void sync_init(Sync* sync, GameData* game, uint16_t id, SyncSend send, void* send_context) {
+  memset(sync, 0, sizeof(Sync));
+  sync->game = game;
+  // Zero marks an empty peer slot
+  sync->id = id == 0 || id == SYNC_BROADCAST ? 1 : id;
+  sync->send = send;
+  sync->send_context = send_context;
+  game_data_set_listener(game, sync_changed, sync);
+  // Anyone who carried on while this watch was away sends the game
+  sync_request(sync, FRAME_RESYNC, SYNC_BROADCAST, game_data_revision(game));
+}
+
+void sync_deinit(Sync* sync) {
+  sync_flush(sync);
+  if (sync->flush_timer) {
+    app_timer_cancel(sync->flush_timer);
+    sync->flush_timer = NULL;
+  }
+  if (sync->tail_timer) {
+    app_timer_cancel(sync->tail_timer);
+    sync->tail_timer = NULL;
+  }
+  game_data_set_listener(sync->game, NULL, NULL);
+}
+
+void sync_flush(Sync* sync) {
+  if (sync->flush_timer) {
+    app_timer_cancel(sync->flush_timer);
+    sync->flush_timer = NULL;
+  }
+  sync_build(sync, FRAME_DELTAS);
+  sync_pump(sync);
+}
+
+void sync_sent(Sync* sync, bool success) {
+  sync->busy = false;
+  if (success) {
+    sync->failures = 0;
+    sync_pump(sync);
+    return;
+  }
+  sync->stats.send_failures++;
+  // Put the frame back in line if it is still held, requests are not
+  // repeated as the peer will ask again
+  if (sync->in_flight_frame && (uint16_t)(sync->seq - sync->in_flight) <= sync->held
+      && (int16_t)(sync->sent - sync->in_flight) > 0) {
+    sync->sent = sync->in_flight;
+  }
+  // Back off while the phone is out of reach
+  uint8_t shift = sync->failures < SYNC_RETRY_MAX_SHIFT ? sync->failures : SYNC_RETRY_MAX_SHIFT;
+  sync->failures++;
+  sync_schedule(sync, SYNC_RETRY_MS << shift);
+}
+
+static SyncPeer* sync_peer(Sync* sync, uint16_t id) {
+  for (uint8_t i = 0; i < SYNC_PEERS; ++i) {
+    if (sync->peers[i].id == id) return &sync->peers[i];
+  }
+  return NULL;
+}
+
+static SyncPeer* sync_add_peer(Sync* sync, uint16_t id, uint16_t expected) {
+  SyncPeer* peer = &sync->peers[sync->next_peer];
+  sync->next_peer = (sync->next_peer + 1) % SYNC_PEERS;
+  peer->id = id;
+  peer->expected = expected;
+  peer->waiting = 0;
+  return peer;
+}
+
+static void sync_resend(Sync* sync, uint16_t from) {
+  uint16_t behind = sync->seq - from;
+  if (behind == 0) return;
+  if (behind > sync->held) {
+    sync_start_resync(sync);
+    return;
+  }
+  if ((int16_t)(sync->sent - from) > 0) {
+    sync->stats.frames_resent += (uint16_t)(sync->sent - from);
+    sync->sent = from;
+  }
+  sync_pump(sync);
+}
+
+static void sync_ask_resend(Sync* sync, SyncPeer* peer) {
+  sync->stats.resend_requests++;
+  sync_request(sync, FRAME_RESEND, peer->id, peer->expected);
+}
+
+// Whichever copy has seen more changes is sent to the other
+static void sync_compare(Sync* sync, uint16_t peer, uint16_t revision) {
+  int16_t ahead = game_data_revision(sync->game) - revision;
+  if (ahead > 0) {
+    sync_start_resync(sync);
+  } else if (ahead < 0) {
+    sync_request(sync, FRAME_RESYNC, peer, game_data_revision(sync->game));
+  }
+}
+
+static bool sync_deltas(Sync* sync, uint16_t id, bool export, uint16_t seq, uint16_t revision,
+                        const uint8_t* data, uint16_t size) {
+  SyncPeer* peer = sync_peer(sync, id);
+  bool joined = !peer && !export;
+  if (!peer) peer = sync_add_peer(sync, id, seq);
+  // A peer not heard from since this watch started may be resending
+  // frames already in the game. Only take a frame that moves it on.
+  if (joined && (int16_t)(revision - game_data_revision(sync->game)) <= 0) {
+    peer->expected = seq + 1;
+    sync_compare(sync, id, revision);
+    return false;
+  }
+  int16_t ahead = seq - peer->expected;
+  // The start of a whole game makes up for anything missed before it
+  if (export && ahead > 0) {
+    peer->expected = seq;
+    ahead = 0;
+  }
+  if (ahead < 0) {
+    sync->stats.duplicates++;
+    return false;
+  }
+  if (ahead > 0) {
+    if (peer->waiting++ % SYNC_RESEND_EVERY == 0) sync_ask_resend(sync, peer);
+    return false;
+  }
+  peer->expected++;
+  peer->waiting = 0;
+  while (size > 0 && data[0] < size) {
+    game_data_apply_remote(sync->game, data + 1, data[0]);
+    sync->stats.records_applied++;
+    size -= 1 + data[0];
+    data += 1 + data[0];
+  }
+  if (joined) sync_compare(sync, id, revision);
+  return true;
+}
+
+bool sync_receive(Sync* sync, const uint8_t* data, uint16_t size) {
+  if (size < FRAME_HEADER) return false;
+  uint16_t id = get_u16(data + 1);
+  uint16_t first = get_u16(data + 3);
+  uint16_t second = get_u16(data + 5);
+  if (id == sync->id) return false;
+  sync->stats.frames_received++;
+  SyncPeer* peer;
+  switch (data[0]) {
+  case FRAME_DELTAS:
+  case FRAME_EXPORT:
+    return sync_deltas(sync, id, data[0] == FRAME_EXPORT, first, second,
+                       data + FRAME_HEADER, size - FRAME_HEADER);
+  case FRAME_RESEND:
+    if (first == sync->id) sync_resend(sync, second);
+    break;
+  case FRAME_RESYNC:
+    // A broadcast comes from a watch that has just started counting
+    if (first == SYNC_BROADCAST && !sync_peer(sync, id)) sync_add_peer(sync, id, 0);
+    if (first == sync->id || first == SYNC_BROADCAST) sync_compare(sync, id, second);
+    break;
+  case FRAME_TAIL:
+    // Nothing is owed once every frame is in, but the games can still
+    // differ if this watch missed the peer starting up
+    peer = sync_peer(sync, id);
+    if (!peer) peer = sync_add_peer(sync, id, first);
+    if ((int16_t)(first - peer->expected) > 0) {
+      sync_ask_resend(sync, peer);
+    } else {
+      sync_compare(sync, id, second);
+    }
+    break;
+  }
+  return false;
+}
\ No newline at end of file
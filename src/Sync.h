@@ -0,0 +1,94 @@
+#pragma once
+#include <pebble.h>
+#include "GameData.h"
+
+// Keeps the game the same on every official's watch. Changes are sent as
+// the records GameData journals, batched into numbered frames. Each watch
+// keeps its last few frames so that a peer which missed one can ask for it
+// again. A peer that has fallen further behind, or was not running, is sent
+// the whole game by whichever watch has seen more changes.
+#define SYNC_FRAME_MAX 96
+#define SYNC_HISTORY 8
+#define SYNC_PEERS 4
+#define SYNC_BROADCAST 0xFFFF
+
+// Hands a frame to the transport, false if it cannot take one right now.
+// The transport reports back through sync_sent().
+typedef bool (*SyncSend)(void* context, const uint8_t* data, uint16_t size);
+
+typedef struct SyncFrame_t {
+  uint16_t seq;
+  uint8_t size;
+  uint8_t data[SYNC_FRAME_MAX];
+} SyncFrame;
+
+typedef struct SyncPeer_t {
+  uint16_t id;
+  // Next frame sequence number due from this peer
+  uint16_t expected;
+  // Frames received out of order since the last request to resend
+  uint8_t waiting;
+} SyncPeer;
+
+typedef struct SyncStats_t {
+  uint32_t frames_sent;
+  uint32_t bytes_sent;
+  uint32_t send_failures;
+  uint32_t frames_received;
+  uint32_t records_applied;
+  uint32_t duplicates;
+  uint32_t resend_requests;
+  uint32_t frames_resent;
+  uint32_t resyncs_sent;
+} SyncStats;
+
+typedef struct Sync_t {
+  GameData* game;
+  SyncSend send;
+  void* send_context;
+  uint16_t id;
+  
+  // Records waiting to go out, flushed as one frame after a short delay
+  uint8_t pending[SYNC_FRAME_MAX];
+  uint8_t pending_size;
+  AppTimer* flush_timer;
+  // Repeats the last seq a few times once things go quiet, for peers that
+  // lost the last frame
+  AppTimer* tail_timer;
+  uint8_t tails;
+  
+  // Ring of built frames. Those from sent up to seq are still to go out,
+  // older ones are kept for resending.
+  SyncFrame history[SYNC_HISTORY];
+  uint8_t held;
+  uint16_t seq;
+  uint16_t sent;
+  
+  // What the transport is busy with, a frame from the ring or a request
+  bool busy;
+  bool in_flight_frame;
+  uint16_t in_flight;
+  uint8_t failures;
+  
+  // One past the export index of the whole-game resync being sent, 0 when
+  // there is none
+  uint16_t resync;
+  // Request or tail waiting for the transport, these are not kept
+  uint8_t control[8];
+  uint8_t control_size;
+  
+  SyncPeer peers[SYNC_PEERS];
+  uint8_t next_peer;
+  SyncStats stats;
+} Sync;
+
+// id must differ between watches, a new one each launch is simplest
+void sync_init(Sync* sync, GameData* game, uint16_t id, SyncSend send, void* send_context);
+void sync_deinit(Sync* sync);
+
+// Returns true if the frame changed the game
+bool sync_receive(Sync* sync, const uint8_t* data, uint16_t size);
+// The transport finished with the last frame handed to it
+void sync_sent(Sync* sync, bool success);
+// Send whatever is pending without waiting for more changes
+void sync_flush(Sync* sync);
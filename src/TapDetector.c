@@ -0,0 +1,83 @@
+#include <pebble.h>
+#include "TapDetector.h"
+
+// Changes between samples are summed over the three axes, in mg. Resting
+// noise is a few tens, a tap on the case over a thousand.
+#define STILL_MAX 200
+#define JOLT_MIN 900
+// A tap follows this many still samples and settles within JOLT_SAMPLES_MAX
+#define STILL_BEFORE 3
+#define JOLT_SAMPLES_MAX 3
+// Gap between the taps of a pair, then the rest before the next pair
+#define PAIR_MIN_MS 150
+#define PAIR_MAX_MS 700
+#define REST_MS 1000
+
+void tap_detector_init(TapDetector* detector) {
+  memset(detector, 0, sizeof(TapDetector));
+}
+
+static uint16_t axis_change(int16_t from, int16_t to) {
+  int32_t change = (int32_t)to - from;
+  return change < 0 ? -change : change;
+}
+
+// A jolt has settled, true if it completes a pair
+static bool jolt_ended(TapDetector* detector) {
+  bool tap = detector->jolt_hard && detector->jolt <= JOLT_SAMPLES_MAX && detector->still_before >= STILL_BEFORE;
+  detector->jolt = 0;
+  if (!tap) {
+    // The wrist was moving, start a pair afresh
+    detector->tapped = false;
+    return false;
+  }
+  if (detector->paired && detector->jolt_at - detector->paired_at < REST_MS) return false;
+  uint32_t gap = detector->jolt_at - detector->tapped_at;
+  if (detector->tapped && gap >= PAIR_MIN_MS && gap <= PAIR_MAX_MS) {
+    detector->tapped = false;
+    detector->paired = true;
+    detector->paired_at = detector->jolt_at;
+    return true;
+  }
+  detector->tapped = true;
+  detector->tapped_at = detector->jolt_at;
+  return false;
+}
+
+static bool tap_detector_sample(TapDetector* detector, const AccelData* sample) {
+  bool primed = detector->primed;
+  uint16_t change = axis_change(detector->x, sample->x) + axis_change(detector->y, sample->y)
+      + axis_change(detector->z, sample->z);
+  detector->x = sample->x;
+  detector->y = sample->y;
+  detector->z = sample->z;
+  // The motor shakes the watch, so nothing around a vibration counts
+  if (!primed || sample->did_vibrate) {
+    detector->primed = !sample->did_vibrate;
+    detector->still = 0;
+    detector->jolt = 0;
+    detector->tapped = false;
+    return false;
+  }
+  if (change > STILL_MAX) {
+    if (detector->jolt == 0) {
+      detector->jolt_at = (uint32_t)sample->timestamp;
+      detector->jolt_hard = false;
+      detector->still_before = detector->still;
+    }
+    if (detector->jolt < UINT8_MAX) detector->jolt++;
+    if (change >= JOLT_MIN) detector->jolt_hard = true;
+    detector->still = 0;
+    return false;
+  }
+  if (detector->still < UINT8_MAX) detector->still++;
+  return detector->jolt && jolt_ended(detector);
+}
+
+uint8_t tap_detector_feed(TapDetector* detector, const AccelData* samples, uint32_t count) {
+  uint8_t pairs = 0;
+  for (uint32_t i = 0; i < count; ++i) {
+    if (tap_detector_sample(detector, &samples[i])) pairs++;
+  }
+  return pairs;
+}
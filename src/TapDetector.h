@@ -0,0 +1,36 @@
+#pragma once
+#include <pebble.h>
+
+// Spots a deliberate double tap on the watch in batches of accelerometer
+// samples. A tap is a short sharp jolt after the wrist has been still, so
+// arm signals, which keep the wrist moving for longer, and the watch's own
+// vibrations are not taken for one. Needs nothing but the samples, so it can
+// be run over recorded ones on a host.
+#define TAP_SAMPLING_HZ 25
+// Samples per batch, the app wakes TAP_SAMPLING_HZ / TAP_BATCH times a second
+#define TAP_BATCH 10
+
+typedef struct TapDetector_t {
+  int16_t x;
+  int16_t y;
+  int16_t z;
+  // False until there is a sample to compare with
+  bool primed;
+  // Still samples in a row, and how many came before the jolt under way
+  uint8_t still;
+  uint8_t still_before;
+  // Samples in the jolt under way, 0 while still
+  uint8_t jolt;
+  bool jolt_hard;
+  uint32_t jolt_at;
+  // The first tap of a possible pair
+  bool tapped;
+  uint32_t tapped_at;
+  // The last pair, taps too soon after it are ignored
+  bool paired;
+  uint32_t paired_at;
+} TapDetector;
+
+void tap_detector_init(TapDetector* detector);
+// Double taps that end in these samples. A pair can span batches.
+uint8_t tap_detector_feed(TapDetector* detector, const AccelData* samples, uint32_t count);
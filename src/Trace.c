@@ -0,0 +1,60 @@
+#include <pebble.h>
+#include "Trace.h"
+
+#ifdef REFWATCH_TRACE
+
+static TraceRecord s_records[TRACE_RECORDS];
+// Next slot to write, and how many slots hold a record
+static uint16_t s_head;
+static uint16_t s_count;
+static bool s_paused;
+// Time of the last button press not yet seen on screen
+static uint32_t s_input_ms;
+static bool s_input_waiting;
+
+static uint32_t trace_now(void) {
+  time_t seconds;
+  uint16_t milliseconds;
+  time_ms(&seconds, &milliseconds);
+  return (uint32_t)seconds * 1000 + milliseconds;
+}
+
+void trace_record(uint8_t event, uint8_t end, uint16_t arg) {
+  if (s_paused) return;
+  s_records[s_head] = (TraceRecord) {
+    .ms = trace_now(), .arg = arg, .event = event, .end = end
+  };
+  s_head = (s_head + 1) % TRACE_RECORDS;
+  if (s_count < TRACE_RECORDS) ++s_count;
+}
+
+void trace_input(void) {
+  s_input_ms = trace_now();
+  s_input_waiting = true;
+}
+
+void trace_frame(void) {
+  if (!s_input_waiting) return;
+  s_input_waiting = false;
+  uint32_t latency = trace_now() - s_input_ms;
+  trace_record(TRACE_FRAME, 1, latency < UINT16_MAX ? latency : UINT16_MAX);
+}
+
+void trace_set_paused(bool paused) {
+  s_paused = paused;
+}
+
+uint16_t trace_count(void) {
+  return s_count;
+}
+
+uint16_t trace_read(uint16_t index, TraceRecord* records, uint16_t max) {
+  uint16_t oldest = (s_head + TRACE_RECORDS - s_count) % TRACE_RECORDS;
+  uint16_t copied = 0;
+  while (copied < max && index < s_count) {
+    records[copied++] = s_records[(oldest + index++) % TRACE_RECORDS];
+  }
+  return copied;
+}
+
+#endif
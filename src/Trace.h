@@ -0,0 +1,56 @@
+#pragma once
+#include <pebble.h>
+
+// Timing of the hot paths, kept in a small ring in RAM and sent to the
+// phone on request. Only built when REFWATCH_TRACE is defined, which the
+// wscript does when REFWATCH_TRACE is set in the build's environment.
+// Otherwise the TRACE_ macros compile to nothing.
+typedef enum {
+  TRACE_DEADLINE,     // arg is the number of deadlines handled
+  TRACE_DRAW_STATIC,
+  TRACE_DRAW_SCORE,   // arg is 0 for the away panel, 1 for home, 2 for the quarter
+  TRACE_DRAW_CHOICE,
+  TRACE_GAME_READ,    // arg is 1 if a game was found
+  TRACE_GAME_WRITE,
+  TRACE_CLICK,        // arg is the ButtonId, with 0x100 set for a long click,
+                      // 0x200 | Chord for a chord, or 0x300 for a wrist tap
+  TRACE_MENU,         // arg is the menu in the high byte and the row in the low
+  TRACE_FRAME,        // arg is the milliseconds from a button press to the
+                      // first frame drawn after it, only end is recorded
+  TRACE_EVENT_COUNT
+} TraceEvent;
+
+#define TRACE_RECORDS 128
+
+// Little endian as sent, Config.js decodes the same layout
+typedef struct __attribute__((__packed__)) TraceRecord_t {
+  // Low 32 bits of the time_ms() reading in milliseconds
+  uint32_t ms;
+  uint16_t arg;
+  uint8_t event;
+  // 0 where the traced code begins, 1 where it ends
+  uint8_t end;
+} TraceRecord;
+
+#ifdef REFWATCH_TRACE
+void trace_record(uint8_t event, uint8_t end, uint16_t arg);
+// Nothing is recorded while paused, so a dump sees a stable ring
+void trace_set_paused(bool paused);
+uint16_t trace_count(void);
+// Copies up to max records, index counting from the oldest, returns how many
+uint16_t trace_read(uint16_t index, TraceRecord* records, uint16_t max);
+// A button press, then each frame drawn. The first frame after a press
+// records TRACE_FRAME.
+void trace_input(void);
+void trace_frame(void);
+
+#define TRACE_BEGIN(event, arg) trace_record(event, 0, arg)
+#define TRACE_END(event, arg) trace_record(event, 1, arg)
+#define TRACE_INPUT() trace_input()
+#define TRACE_FRAME_DRAWN() trace_frame()
+#else
+#define TRACE_BEGIN(event, arg) do {} while (0)
+#define TRACE_END(event, arg) do {} while (0)
+#define TRACE_INPUT() do {} while (0)
+#define TRACE_FRAME_DRAWN() do {} while (0)
+#endif
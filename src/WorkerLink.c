@@ -0,0 +1,40 @@
+#include <pebble.h>
+#include "WorkerLink.h"
+
+bool worker_link_take_over() {
+  // Nothing for the worker to do while the app runs the clock
+  app_worker_kill();
+  return launch_reason() == APP_LAUNCH_WORKER;
+}
+
+// The worker holds one deadline, the first clock to run out, and is only
+// running while there is one
+void worker_link_hand_over(GameData* data) {
+  uint32_t seconds = 0;
+  uint16_t milliseconds = 0;
+  for (int i = 0; i < CLOCK_COUNT; ++i) {
+    uint32_t clock_seconds;
+    uint16_t clock_ms;
+    if (!game_data_clock_deadline(data, i, &clock_seconds, &clock_ms)) continue;
+    if ((!seconds && !milliseconds) || (int32_t)(clock_seconds - seconds) < 0
+        || (clock_seconds == seconds && clock_ms < milliseconds)) {
+      seconds = clock_seconds;
+      milliseconds = clock_ms;
+    }
+  }
+  if (!seconds && !milliseconds) {
+    app_worker_kill();
+    return;
+  }
+  AppWorkerMessage message = {
+    .data0 = seconds & 0xFFFF,
+    .data1 = seconds >> 16,
+    .data2 = milliseconds
+  };
+  if (app_worker_is_running()) {
+    app_worker_send_message(WORKER_CLOCK, &message);
+    return;
+  }
+  persist_write_data(WORKER_CLOCK_KEY, &message, sizeof(message));
+  app_worker_launch();
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include <pebble.h>
+#include "GameData.h"
+#include "WorkerMessage.h"
+
+// Hand-off of the running clock between the app and the background worker.
+// While the app is open it runs the clock itself and no worker runs. When it
+// closes with a clock running it launches the worker with the deadline,
+// which sleeps until then and opens the app again to sound the alert. Only
+// the deadline is handed over, the game itself still comes back from the
+// snapshot and journal on launch.
+//
+// Stops the worker and takes the clock back from it. Returns true if the
+// worker opened the app because the clock ran out.
+bool worker_link_take_over();
+// Passes the clock to the worker as the app closes
+void worker_link_hand_over(GameData* data);
@@ -0,0 +1,15 @@
+#pragma once
+
+// Messages between the app and the background worker in worker_src/,
+// shared by both so it includes nothing from either SDK.
+//
+// WORKER_CLOCK, app to worker: the running clock's deadline as time_ms()
+// seconds in data0 (low half) and data1 (high half), milliseconds in
+// data2. All zero means there is nothing to watch.
+typedef enum {
+  WORKER_CLOCK
+} WorkerMessageType;
+
+// A worker just launched has not subscribed to messages yet, so the
+// WORKER_CLOCK it is launched for waits for it in this persist key
+#define WORKER_CLOCK_KEY 102
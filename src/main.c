@@ -2,119 +2,338 @@
 #include "ChoiceLayer.h"
 #include "GameData.h"
 #include "AppConfig.h"
+#include "Sync.h"
+#include "WorkerLink.h"
+#include "Trace.h"
+#include "HeapStats.h"
+#include "Activity.h"
+#include "Archive.h"
+#include "TapDetector.h"
   
 static GameData game_data;
+static Sync s_sync;
 
 static Window *s_main_window;
 static Layer *s_static_layer;
-static Layer *s_score_layer;
+// The score panel is split so a change only marks its own region dirty
+static Layer *s_team_layers[2];
+static Layer *s_quarter_layer;
 static TextLayer *s_time_layer;
+static TextLayer *s_game_time_layer;
 
+// Menus, lists and choices share one window. Its layers are made once and
+// swapped in place, so only opening it from the main window and going back
+// animate.
 static Window* s_menu_window;
 static MenuLayer* s_menu_layer;
-
-static Window* s_choice_window;
 static ChoiceLayer* s_choice_layer;
+static bool s_choice_shown;
 
 static NumberWindow* s_number_window;
-int16_t ceil_int(double val) {
-  int16_t ret = (int16_t) val;
-  if (val - ret != 0) ++ret;
-  return ret;
-}
+
 static void back_to_main() {
+  // Anything over the menus goes first, then the menus animate away
   Window* current = window_stack_get_top_window();
   while (current && current != s_main_window) {
-    window_stack_pop(false);
+    window_stack_pop(current == s_menu_window);
     current = window_stack_get_top_window();
   }
 }
 
+// Fonts are looked up once when the main window loads
+static GFont s_team_font;
+static GFont s_score_font;
+static GFont s_quarter_font;
+
+// What each region of the score panel shows, away then home. update_display
+// compares against it and the draw procs only read it.
+typedef struct TeamPanel_t {
+  uint16_t total;
+  uint8_t timeouts;
+  char score[6];
+} TeamPanel;
+
+static TeamPanel s_team_panels[2];
+static const char* s_quarter_shown;
+
+// The team labels never change. They are drawn as text once, then kept as
+// a copy of the frame buffer rows they cover and blitted on every later
+// redraw of the window. The window is still sliding in when it appears, so
+// the rows are only copied once it has been on screen for
+// STATIC_SETTLE_MS, and drawn as text until then.
+#define STATIC_SETTLE_MS 500
+static GBitmap* s_static_bitmap;
+static bool s_static_settled;
+static AppTimer* s_static_settle_timer;
+
+// Copies whole rows of the frame buffer. The layer is a child of the root
+// layer, which is at the top left of the screen. Round screens keep their
+// rows at varying offsets and are not cached.
+static GBitmap* capture_rows(GContext* ctx, int16_t y, int16_t height) {
+#ifdef PBL_ROUND
+  return NULL;
+#else
+  GBitmap* frame_buffer = graphics_capture_frame_buffer(ctx);
+  if (!frame_buffer) return NULL;
+  GRect screen = gbitmap_get_bounds(frame_buffer);
+  GBitmap* bitmap = gbitmap_create_blank((GSize) { .w = screen.size.w, .h = height },
+                                         gbitmap_get_format(frame_buffer));
+  if (bitmap) {
+    uint16_t from_row = gbitmap_get_bytes_per_row(frame_buffer);
+    uint16_t to_row = gbitmap_get_bytes_per_row(bitmap);
+    uint16_t row_size = from_row < to_row ? from_row : to_row;
+    for (int16_t row = 0; row < height; ++row) {
+      memcpy(gbitmap_get_data(bitmap) + row * to_row,
+             gbitmap_get_data(frame_buffer) + (y + row) * from_row, row_size);
+    }
+  }
+  graphics_release_frame_buffer(ctx, frame_buffer);
+  return bitmap;
+#endif
+}
+
 static void draw_static(Layer* layer, GContext* ctx) {
-  GFont team_font = fonts_get_system_font(FONT_KEY_GOTHIC_14_BOLD);
-  graphics_context_set_text_color(ctx, GColorBlack);
-  GRect bounds = layer_get_bounds(layer); 
-  graphics_draw_text(ctx, "AWAY", team_font, (GRect){
-      .origin = {.x = 0, . y = 0}, .size = {.h = bounds.size.h, .w = bounds.size.w / 2}
-  }, GTextOverflowModeFill, GTextAlignmentCenter, NULL);
-  graphics_draw_text(ctx, "HOME", team_font, (GRect){
-      .origin = {.x = bounds.size.w / 2, . y = 0}, .size = {.h = bounds.size.h, .w = bounds.size.w / 2}
-  }, GTextOverflowModeFill, GTextAlignmentCenter, NULL);
+  TRACE_BEGIN(TRACE_DRAW_STATIC, 0);
+  activity_count(ACTIVITY_REDRAW);
+  GRect frame = layer_get_frame(layer);
+  if (s_static_bitmap) {
+    // Rows are whole screen width, the layer clips them back to its frame
+    graphics_draw_bitmap_in_rect(ctx, s_static_bitmap, (GRect) {
+        .origin = {.x = -frame.origin.x, .y = 0}, .size = gbitmap_get_bounds(s_static_bitmap).size
+    });
+  } else {
+    graphics_context_set_text_color(ctx, GColorBlack);
+    GRect bounds = layer_get_bounds(layer); 
+    graphics_draw_text(ctx, "AWAY", s_team_font, (GRect){
+        .origin = {.x = 0, . y = 0}, .size = {.h = bounds.size.h, .w = bounds.size.w / 2}
+    }, GTextOverflowModeFill, GTextAlignmentCenter, NULL);
+    graphics_draw_text(ctx, "HOME", s_team_font, (GRect){
+        .origin = {.x = bounds.size.w / 2, . y = 0}, .size = {.h = bounds.size.h, .w = bounds.size.w / 2}
+    }, GTextOverflowModeFill, GTextAlignmentCenter, NULL);
+    if (s_static_settled) {
+      int32_t heap_mark = heap_stats_mark();
+      s_static_bitmap = capture_rows(ctx, frame.origin.y, frame.size.h);
+      heap_stats_charge(HEAP_LAYERS, heap_mark);
+    }
+  }
+  TRACE_END(TRACE_DRAW_STATIC, 0);
 }
 
-static void draw_team_data(Layer* layer, GContext* ctx, TeamData* data, int x_offset, int width) {
-  GFont score_font = fonts_get_system_font(FONT_KEY_BITHAM_34_MEDIUM_NUMBERS);
-  char buffer[4];
-  
-  snprintf(buffer, 4, "%d", data->total);
-  graphics_draw_text(ctx, buffer, score_font, (GRect){
-      .origin = {.x = x_offset, . y = -3}, .size = {.h = 28, .w = width}
+static void static_settled(void* data) {
+  activity_count(ACTIVITY_WAKEUP);
+  s_static_settle_timer = NULL;
+  s_static_settled = true;
+  layer_mark_dirty(s_static_layer);
+}
+
+// Once copied the rows are good for the life of the window
+static void static_settle(bool visible) {
+  if (s_static_settle_timer) {
+    app_timer_cancel(s_static_settle_timer);
+    s_static_settle_timer = NULL;
+  }
+  s_static_settled = false;
+  if (visible && !s_static_bitmap) {
+    s_static_settle_timer = app_timer_register(STATIC_SETTLE_MS, static_settled, NULL);
+  }
+}
+
+static void draw_team_panel(Layer* layer, GContext* ctx, int home) {
+  TRACE_BEGIN(TRACE_DRAW_SCORE, home);
+  activity_count(ACTIVITY_REDRAW);
+  const TeamPanel* panel = &s_team_panels[home];
+  GRect bounds = layer_get_bounds(layer);
+  graphics_context_set_text_color(ctx, GColorBlack);
+  graphics_context_set_fill_color(ctx, GColorBlack);
+  graphics_draw_text(ctx, panel->score, s_score_font, (GRect){
+      .origin = {.x = 0, . y = -3}, .size = {.h = 28, .w = bounds.size.w}
   }, GTextOverflowModeFill, GTextAlignmentCenter, NULL);
   
-  for (int i = 0; i < data->timeouts; ++i) {
+  for (int i = 0; i < panel->timeouts; ++i) {
     graphics_fill_rect(ctx, (GRect) {
-      .origin = {.x = x_offset + i * 15 + 13, .y = 38}, .size = {.w = 13, .h = 4}
+      .origin = {.x = i * 15 + 13, .y = 38}, .size = {.w = 13, .h = 4}
     }, 0, GCornerNone);
   }
-  
+  TRACE_END(TRACE_DRAW_SCORE, home);
+}
+
+static void draw_away_panel(Layer* layer, GContext* ctx) {
+  draw_team_panel(layer, ctx, 0);
 }
 
-static void draw_game_data(Layer* layer, GContext* ctx) {  
-  GFont quarter_font = fonts_get_system_font(FONT_KEY_GOTHIC_28);
+static void draw_home_panel(Layer* layer, GContext* ctx) {
+  draw_team_panel(layer, ctx, 1);
+}
+
+static void draw_quarter(Layer* layer, GContext* ctx) {
+  TRACE_BEGIN(TRACE_DRAW_SCORE, 2);
+  activity_count(ACTIVITY_REDRAW);
   graphics_context_set_text_color(ctx, GColorBlack);
-  graphics_context_set_fill_color(ctx, GColorBlack);
   GRect bounds = layer_get_bounds(layer);
-  
-  int x_offset = 0;
-  int width = bounds.size.w / 2;
-
-  draw_team_data(layer, ctx, &game_data.away, x_offset, width);
-  draw_team_data(layer, ctx, &game_data.home, width, width);
-  
-  graphics_draw_text(ctx, quarter_to_text(game_data.quarter), quarter_font, (GRect) {
-    .origin = {.x = 0, .y = 40}, .size = {.w = bounds.size.w, .h = 24}
+  graphics_draw_text(ctx, s_quarter_shown, s_quarter_font, (GRect) {
+    .origin = {.x = 0, .y = 0}, .size = {.w = bounds.size.w, .h = 24}
   }, GTextOverflowModeFill, GTextAlignmentCenter, NULL);
+  TRACE_END(TRACE_DRAW_SCORE, 2);
 }
 
-static void start_timer();
-static void stop_timer();
+static const char s_two_digits[] =
+  "0001020304050607080910111213141516171819"
+  "2021222324252627282930313233343536373839"
+  "4041424344454647484950515253545556575859"
+  "6061626364656667686970717273747576777879"
+  "8081828384858687888990919293949596979899";
+
+// What the time layer currently shows, so unchanged ticks don't redraw it
+static char s_time_text[7];
+static uint16_t s_time_shown;
+static int8_t s_time_inverted;
+// The game clock under another clock, UINT16_MAX while it is hidden
+static char s_game_time_text[12] = "GAME ";
+static uint16_t s_game_time_shown;
+
+static void format_time(char* buffer, uint16_t total_seconds) {
+  uint16_t minutes = total_seconds / 60;
+  const char* seconds = &s_two_digits[(total_seconds % 60) * 2];
+  if (minutes >= 100) {
+    *buffer++ = '0' + (minutes / 100) % 10;
+    minutes %= 100;
+  }
+  *buffer++ = s_two_digits[minutes * 2];
+  *buffer++ = s_two_digits[minutes * 2 + 1];
+  *buffer++ = ':';
+  *buffer++ = seconds[0];
+  *buffer++ = seconds[1];
+  *buffer = '\0';
+}
+
+static void update_game_time() {
+  uint16_t total_seconds = UINT16_MAX;
+  if (game_data.shown != CLOCK_GAME) total_seconds = game_data_clock_get_seconds(&game_data, CLOCK_GAME);
+  if (total_seconds == s_game_time_shown) return;
+  layer_set_hidden(text_layer_get_layer(s_game_time_layer), total_seconds == UINT16_MAX);
+  s_game_time_shown = total_seconds;
+  if (total_seconds == UINT16_MAX) return;
+  format_time(s_game_time_text + 5, total_seconds);
+  text_layer_set_text(s_game_time_layer, s_game_time_text);
+  activity_count(ACTIVITY_DIRTY);
+}
 
 static void update_time(void* ctx) {
-  static char buffer[10];
-  uint16_t total_seconds = ceil_int(game_data_timer_get_value(&game_data));
-  snprintf(buffer, 10, "%02d:%02d", total_seconds / 60, total_seconds % 60);
-  text_layer_set_text(s_time_layer, buffer);
+  update_game_time();
+  uint16_t total_seconds = game_data_clock_get_seconds(&game_data, game_data.shown);
+  if (total_seconds == s_time_shown) return;
+  s_time_shown = total_seconds;
+  format_time(s_time_text, total_seconds);
+  text_layer_set_text(s_time_layer, s_time_text);
+  activity_count(ACTIVITY_DIRTY);
 }
 
+static bool update_team_panel(TeamPanel* panel, const TeamData* data) {
+  if (panel->total == data->total && panel->timeouts == data->timeouts) return false;
+  panel->total = data->total;
+  panel->timeouts = data->timeouts;
+  snprintf(panel->score, sizeof(panel->score), "%d", data->total);
+  return true;
+}
+
+// Marks only the regions whose state changed, nothing if none did
+static void update_tap_control();
+
+// Also the one place tap control follows the shown clock, so resets and
+// config changes that move it turn the accelerometer off
 static void update_display() {
-  layer_mark_dirty(s_score_layer);
+  update_tap_control();
+  for (int home = 0; home < 2; ++home) {
+    if (update_team_panel(&s_team_panels[home], home ? &game_data.home : &game_data.away)) {
+      layer_mark_dirty(s_team_layers[home]);
+      activity_count(ACTIVITY_DIRTY);
+    }
+  }
+  const char* quarter = quarter_to_text(game_data.quarter);
+  if (quarter != s_quarter_shown) {
+    s_quarter_shown = quarter;
+    layer_mark_dirty(s_quarter_layer);
+    activity_count(ACTIVITY_DIRTY);
+  }
 }
 
-static void on_start(void* ctx) {
-  text_layer_set_text_color(s_time_layer, GColorWhite);
-  text_layer_set_background_color(s_time_layer, GColorBlack);
+static void set_time_inverted(bool inverted) {
+  if (s_time_inverted == inverted) return;
+  s_time_inverted = inverted;
+  text_layer_set_text_color(s_time_layer, inverted ? GColorWhite : GColorBlack);
+  text_layer_set_background_color(s_time_layer, inverted ? GColorBlack : GColorWhite);
 }
 
-static void on_stop(void* ctx) {
-  text_layer_set_text_color(s_time_layer, GColorBlack);
-  text_layer_set_background_color(s_time_layer, GColorWhite);
+// The big clock is inverted while it runs
+static void on_start(ClockId clock) {
+  if (clock == game_data.shown) set_time_inverted(true);
+}
+
+static void on_stop(ClockId clock) {
+  if (clock == game_data.shown) set_time_inverted(false);
 }
 
-static void on_expire(void* ctx) {
-  update_time(ctx);
-  vibes_long_pulse();
+// Each clock has its own feel, so an official can tell them apart without
+// looking. Warnings are pulses, running out is one long buzz.
+static const uint32_t s_game_warning_segments[] = { 200, 150, 200 };
+static const uint32_t s_play_warning_segments[] = { 100 };
+static const uint32_t s_break_warning_segments[] = { 100, 100, 100, 100, 100 };
+static const uint32_t s_game_expiry_segments[] = { 1000 };
+static const uint32_t s_play_expiry_segments[] = { 600 };
+static const uint32_t s_break_expiry_segments[] = { 600, 200, 600 };
+
+#define VIBE_PATTERN(segments) { .durations = segments, .num_segments = ARRAY_LENGTH(segments) }
+static const VibePattern s_warning_patterns[CLOCK_COUNT] = {
+  VIBE_PATTERN(s_game_warning_segments),
+  VIBE_PATTERN(s_play_warning_segments),
+  VIBE_PATTERN(s_break_warning_segments)
+};
+static const VibePattern s_expiry_patterns[CLOCK_COUNT] = {
+  VIBE_PATTERN(s_game_expiry_segments),
+  VIBE_PATTERN(s_play_expiry_segments),
+  VIBE_PATTERN(s_break_expiry_segments)
+};
+
+static void on_warning(ClockId clock) {
+  vibes_enqueue_custom_pattern(s_warning_patterns[clock]);
+  activity_count(ACTIVITY_VIBE);
 }
 
-static void start_timer() {
-  game_data_timer_start(&game_data);
+static void on_expire(ClockId clock) {
+  update_time(NULL);
+  vibes_enqueue_custom_pattern(s_expiry_patterns[clock]);
+  activity_count(ACTIVITY_VIBE);
 }
 
-static void stop_timer() {
-  game_data_timer_stop(&game_data);
+static void show_clock(ClockId clock) {
+  game_data_clock_show(&game_data, clock);
+  set_time_inverted(game_data_clock_is_running(&game_data, clock));
 }
 
+#ifdef REFWATCH_TRACE
+// Added last to each window so it is drawn in every frame, to time how long
+// a button press takes to show
+static Layer* s_frame_probes[2];
+
+static void draw_frame_probe(Layer* layer, GContext* ctx) {
+  TRACE_FRAME_DRAWN();
+}
+
+static Layer* add_frame_probe(Window* window) {
+  Layer* root = window_get_root_layer(window);
+  Layer* probe = layer_create((GRect) { .origin = {.x = 0, .y = 0}, .size = {.w = 1, .h = 1} });
+  layer_set_update_proc(probe, draw_frame_probe);
+  layer_add_child(root, probe);
+  return probe;
+}
+#endif
+
 static void main_window_load(Window *window) {
+  int32_t heap_mark = heap_stats_mark();
   Layer* root_layer = window_get_root_layer(window);
+  s_team_font = fonts_get_system_font(FONT_KEY_GOTHIC_14_BOLD);
+  s_score_font = fonts_get_system_font(FONT_KEY_BITHAM_34_MEDIUM_NUMBERS);
+  s_quarter_font = fonts_get_system_font(FONT_KEY_GOTHIC_28);
   // Create static layer
   s_static_layer = layer_create((GRect){
     .origin = {.x = 5, .y = 5}, .size = {.w = 134, .h = 15}
@@ -124,12 +343,25 @@ static void main_window_load(Window *window) {
   layer_add_child(root_layer, s_static_layer);
   layer_mark_dirty(s_static_layer);
   
-  s_score_layer = layer_create((GRect) {
-    .origin = {.x = 5, .y = 20}, .size = {.w = 134, .h = 70}
+  s_team_layers[0] = layer_create((GRect) {
+    .origin = {.x = 5, .y = 20}, .size = {.w = 67, .h = 42}
+  });
+  layer_set_update_proc(s_team_layers[0], draw_away_panel);
+  layer_add_child(root_layer, s_team_layers[0]);
+  s_team_layers[1] = layer_create((GRect) {
+    .origin = {.x = 72, .y = 20}, .size = {.w = 67, .h = 42}
   });
-  layer_set_update_proc(s_score_layer, draw_game_data);
-  layer_add_child(root_layer, s_score_layer);
+  layer_set_update_proc(s_team_layers[1], draw_home_panel);
+  layer_add_child(root_layer, s_team_layers[1]);
+  s_quarter_layer = layer_create((GRect) {
+    .origin = {.x = 5, .y = 60}, .size = {.w = 134, .h = 30}
+  });
+  layer_set_update_proc(s_quarter_layer, draw_quarter);
+  layer_add_child(root_layer, s_quarter_layer);
   
+  // New layers, so everything is shown afresh
+  for (int home = 0; home < 2; ++home) s_team_panels[home].total = UINT16_MAX;
+  s_quarter_shown = NULL;
   update_display();
   
   s_time_layer = text_layer_create((GRect){
@@ -138,135 +370,222 @@ static void main_window_load(Window *window) {
   text_layer_set_font(s_time_layer, fonts_get_system_font(FONT_KEY_BITHAM_42_MEDIUM_NUMBERS));
   text_layer_set_text_color(s_time_layer, GColorBlack);
   text_layer_set_text_alignment(s_time_layer, GTextAlignmentCenter);
+  s_time_shown = UINT16_MAX;
+  s_time_inverted = false;
   layer_add_child(root_layer, text_layer_get_layer(s_time_layer));
-  game_data_timer_set_callbacks(&game_data, on_start, on_stop, update_time, on_expire);
-  update_time(NULL);
+  
+  s_game_time_layer = text_layer_create((GRect){
+    .origin = {.x = 5, .y = 146}, .size = {.h = 22, .w = 134}
+  });
+  text_layer_set_font(s_game_time_layer, fonts_get_system_font(FONT_KEY_GOTHIC_18_BOLD));
+  text_layer_set_text_alignment(s_game_time_layer, GTextAlignmentCenter);
+  s_game_time_shown = UINT16_MAX;
+  layer_set_hidden(text_layer_get_layer(s_game_time_layer), true);
+  layer_add_child(root_layer, text_layer_get_layer(s_game_time_layer));
+  
+  for (int i = 0; i < CLOCK_COUNT; ++i) {
+    game_data_clock_set_callbacks(&game_data, i, (ClockCallbacks) {
+      .on_start = on_start, .on_stop = on_stop, .on_warning = on_warning, .on_expire = on_expire
+    });
+  }
+  game_data_set_tick_callback(&game_data, update_time);
+#ifdef REFWATCH_TRACE
+  s_frame_probes[0] = add_frame_probe(window);
+#endif
+  heap_stats_charge(HEAP_LAYERS, heap_mark);
 }
 
 static void main_window_unload(Window *window) {
+  int32_t heap_mark = heap_stats_mark();
   // Destroy Layers
+  static_settle(false);
   layer_destroy(s_static_layer);
-  layer_destroy(s_score_layer);
+  if (s_static_bitmap) {
+    gbitmap_destroy(s_static_bitmap);
+    s_static_bitmap = NULL;
+  }
+  layer_destroy(s_team_layers[0]);
+  layer_destroy(s_team_layers[1]);
+  layer_destroy(s_quarter_layer);
   text_layer_destroy(s_time_layer);
+  text_layer_destroy(s_game_time_layer);
+#ifdef REFWATCH_TRACE
+  layer_destroy(s_frame_probes[0]);
+#endif
+  heap_stats_charge(HEAP_LAYERS, heap_mark);
 }
 
-typedef void (*MenuCallback)(void* data, int index);
-static void show_menu(const char** text, int number, MenuCallback callback);
+// The menus are one graph in flash. Each row does an action and then leads
+// to another menu, back to the main window, or stays on whatever the action
+// opened. One dispatcher walks it.
+typedef enum {
+  MENU_MAIN,
+  MENU_NEW,
+  MENU_SCORE_TEAM,
+  MENU_PENALTY_TEAM,
+  MENU_TIMEOUT_TEAM,
+  MENU_SCORE,
+  MENU_TRY,
+  MENU_VIEW,
+  MENU_TIME,
+  MENU_CLOCK,
+  MENU_COUNT,
+  // Row destinations that are not menus
+  MENU_BACK = MENU_COUNT,
+  MENU_HOLD
+} MenuId;
 
-static const char* main_scores_items[] = {"Touchdown", "Field Goal", "Safety"};
-static const char* try_scores_items[] = {"2-point", "1-point", "Failed"};
-static const char* team_items[] = {"Home Team", "Away Team", "Cancel"};
-static const char* view_items[] = {"Scores", "Penalties", "Timeouts"};
-static const char* new_items[] = {"Score", "Penalty", "Timeout"};
-static const char* main_menu_items[] = {"New...", "View...", "Reset Game"};
-static const char* clock_menu_items[] = {"Game Clock", "Play Clock", "Timeout", "Half"};
-static const char* time_menu_items[] = {"Reset", "End Quarter", "Change Clock"};
+typedef enum {
+  ACTION_NONE,
+  ACTION_TEAM,      // arg is 1 for the home team
+  ACTION_SCORE,     // arg is the points
+  ACTION_TRY,       // arg is the points
+  ACTION_PENALTY,   // arg is 1 for the home team, asks for the number
+  ACTION_TIMEOUT,   // arg is 1 for the home team
+  ACTION_UNDO,
+  ACTION_RESET_GAME,
+  ACTION_LIST,      // arg is a mask of event kinds
+  ACTION_SUMMARY,
+  ACTION_ACTIVITY,
+  ACTION_ARCHIVE,
+  ACTION_CLOCK_RESET,
+  ACTION_END_QUARTER,
+  ACTION_CLOCK,     // arg is the ClockId to show
+  ACTION_BREAK      // arg is the length of the break in seconds
+} MenuAction;
 
-static const char** current_menu_text = try_scores_items;
-static int current_menu_number = 3;
-static MenuCallback current_menu_callback;
+typedef struct MenuItem_t {
+  uint8_t action;
+  uint8_t next;
+  uint16_t arg;
+} MenuItem;
 
-static const char* penalty_window_text = "Number of player";
+#define MENU_ROWS_MAX 5
 
-static void main_score(void* data, int index) {
-  uint8_t points = 0;
-  switch (index) {
-    case 0: points = 6; break;
-    case 1: points = 3; break;
-    case 2: points = 2; break;
-  }
-  team_data_new_score(game_data.home_team_active?&game_data.home:&game_data.away, points, game_data.quarter, 0);
-  if (points == 6) game_data.try_active = true;
-  update_display();
-  back_to_main();
-}
+// Up to three rows are shown as a ChoiceLayer, more as a MenuLayer
+typedef struct MenuNode_t {
+  const char* labels[MENU_ROWS_MAX];
+  MenuItem items[MENU_ROWS_MAX];
+  uint8_t count;
+  // Shown instead while a try is pending, MENU_COUNT if the same
+  uint8_t during_try;
+} MenuNode;
 
-static void set_team_score(void* data, int index) {
-  if (index == 2) { 
-    back_to_main();
-    return;
-  }
-  game_data.home_team_active = index == 0;
-  current_menu_text = main_scores_items;
-  current_menu_number = 3;
-  current_menu_callback = main_score;
-  show_menu(main_scores_items, 3, main_score);
-}
+#define TEAM_LABELS { "Home Team", "Away Team", "Cancel" }
+#define CANCEL { ACTION_NONE, MENU_BACK, 0 }
 
-static void try_score(void* data, int index) {
-  uint8_t points = 0;
-  switch (index) {
-    case 0: points = 2; break;
-    case 1: points = 1; break;
-    case 2: points = 0; break;
+static const MenuNode s_menus[MENU_COUNT] = {
+  [MENU_MAIN] = {
+    .labels = { "New...", "View...", "Undo", "Reset Game", "Past Games" },
+    .items = {
+      { ACTION_NONE, MENU_NEW, 0 },
+      { ACTION_NONE, MENU_VIEW, 0 },
+      { ACTION_UNDO, MENU_BACK, 0 },
+      { ACTION_RESET_GAME, MENU_BACK, 0 },
+      { ACTION_ARCHIVE, MENU_HOLD, 0 }
+    },
+    .count = 5, .during_try = MENU_COUNT
+  },
+  [MENU_NEW] = {
+    .labels = { "Score", "Penalty", "Timeout" },
+    .items = {
+      { ACTION_NONE, MENU_SCORE_TEAM, 0 },
+      { ACTION_NONE, MENU_PENALTY_TEAM, 0 },
+      { ACTION_NONE, MENU_TIMEOUT_TEAM, 0 }
+    },
+    .count = 3, .during_try = MENU_COUNT
+  },
+  [MENU_SCORE_TEAM] = {
+    .labels = TEAM_LABELS,
+    .items = { { ACTION_TEAM, MENU_SCORE, 1 }, { ACTION_TEAM, MENU_SCORE, 0 }, CANCEL },
+    .count = 3, .during_try = MENU_TRY
+  },
+  [MENU_PENALTY_TEAM] = {
+    .labels = TEAM_LABELS,
+    .items = { { ACTION_PENALTY, MENU_HOLD, 1 }, { ACTION_PENALTY, MENU_HOLD, 0 }, CANCEL },
+    .count = 3, .during_try = MENU_COUNT
+  },
+  [MENU_TIMEOUT_TEAM] = {
+    .labels = TEAM_LABELS,
+    .items = { { ACTION_TIMEOUT, MENU_BACK, 1 }, { ACTION_TIMEOUT, MENU_BACK, 0 }, CANCEL },
+    .count = 3, .during_try = MENU_COUNT
+  },
+  [MENU_SCORE] = {
+    .labels = { "Touchdown", "Field Goal", "Safety" },
+    .items = { { ACTION_SCORE, MENU_BACK, 6 }, { ACTION_SCORE, MENU_BACK, 3 }, { ACTION_SCORE, MENU_BACK, 2 } },
+    .count = 3, .during_try = MENU_COUNT
+  },
+  [MENU_TRY] = {
+    .labels = { "2-point", "1-point", "Failed" },
+    .items = { { ACTION_TRY, MENU_BACK, 2 }, { ACTION_TRY, MENU_BACK, 1 }, { ACTION_TRY, MENU_BACK, 0 } },
+    .count = 3, .during_try = MENU_COUNT
+  },
+  [MENU_VIEW] = {
+    .labels = { "Scores", "Penalties", "Timeouts", "By Quarter", "Activity" },
+    .items = {
+      { ACTION_LIST, MENU_HOLD, 1 << EVENT_SCORE | 1 << EVENT_TRY },
+      { ACTION_LIST, MENU_HOLD, 1 << EVENT_PENALTY },
+      { ACTION_LIST, MENU_HOLD, 1 << EVENT_TIMEOUT },
+      { ACTION_SUMMARY, MENU_HOLD, 0 },
+      { ACTION_ACTIVITY, MENU_HOLD, 0 }
+    },
+    .count = 5, .during_try = MENU_COUNT
+  },
+  [MENU_TIME] = {
+    .labels = { "Reset", "End Quarter", "Change Clock" },
+    .items = {
+      { ACTION_CLOCK_RESET, MENU_BACK, 0 },
+      { ACTION_END_QUARTER, MENU_BACK, 0 },
+      { ACTION_NONE, MENU_CLOCK, 0 }
+    },
+    .count = 3, .during_try = MENU_COUNT
+  },
+  // The game clock carries on as it was, the others start afresh
+  [MENU_CLOCK] = {
+    .labels = { "Game Clock", "Play Clock", "Timeout", "Half" },
+    .items = {
+      { ACTION_CLOCK, MENU_BACK, CLOCK_GAME },
+      { ACTION_CLOCK, MENU_BACK, CLOCK_PLAY },
+      { ACTION_BREAK, MENU_BACK, BREAK_CLOCK_SECONDS },
+      { ACTION_BREAK, MENU_BACK, 60 * 20 }
+    },
+    .count = 4, .during_try = MENU_COUNT
   }
-  team_data_add_pat(game_data.home_team_active?&game_data.home:&game_data.away, points);
-  game_data.try_active = false;
-  update_display();
-  back_to_main();
-}
+};
 
-static TeamData* new_team;
+// The menu on screen, and the team picked for a score or penalty
+static uint8_t s_menu;
+static bool s_menu_home;
 
-void select_new(void* data, int index) {
-  switch (index) {
-    case 0:
-      game_data.home_team_active = new_team == &game_data.home;
-      if (game_data.try_active) {
-        show_menu(try_scores_items, 3, try_score);
-      } else {
-        show_menu(main_scores_items, 3, main_score);
-      }
-      break;
-    case 1: 
-      window_stack_push(number_window_get_window(s_number_window), true);
-      break;
-    case 2: new_team->timeouts--; back_to_main(); break;
+static const char* penalty_window_text = "Number of player";
+
+// The event log has a fixed budget and teams a set number of timeouts, let
+// the official know when an entry is refused
+static void check_recorded(bool recorded) {
+  if (!recorded) {
+    APP_LOG(APP_LOG_LEVEL_WARNING, "Event not recorded");
+    vibes_double_pulse();
+    activity_count(ACTIVITY_VIBE);
   }
 }
 
 static void penalty_select(NumberWindow* window, void* data) {
-  game_list_add(&new_team->penalties, number_window_get_value(s_number_window), game_data.quarter, 0);
+  check_recorded(game_data_add_penalty(&game_data, s_menu_home, number_window_get_value(s_number_window)));
   back_to_main();
 }
-static int new_index;
-
-static void set_team_new(void* data, int index) {
-  switch (index) {
-    case 0: new_team = &game_data.home; break;
-    case 1: new_team = &game_data.away; break;
-    case 2: back_to_main(); return;
-  }
-  switch (new_index) {
-    case 0:
-      game_data.home_team_active = new_team == &game_data.home;
-      if (game_data.try_active) {
-        show_menu(try_scores_items, 3, try_score);
-      } else {
-        show_menu(main_scores_items, 3, main_score);
-      }
-      break;
-    case 1: 
-      window_stack_push(number_window_get_window(s_number_window), true);
-      break;
-    case 2: new_team->timeouts--; back_to_main(); break;
-  }
-}
 
-static void set_new_item(void* data, int index) {
-  new_index = index;
-  show_menu(team_items, 3, set_team_new);
-}
 static uint16_t get_menu_rows_number(MenuLayer* layer, uint16_t section, void* data) {
-  return current_menu_number;
+  return s_menus[s_menu].count;
 }
 
 static void draw_menu_row(GContext* ctx, const Layer* cell_layer, MenuIndex* index, void* data) {
-  menu_cell_basic_draw(ctx, cell_layer, current_menu_text[index->row], NULL, NULL);
+  menu_cell_basic_draw(ctx, cell_layer, s_menus[s_menu].labels[index->row], NULL, NULL);
 }
 
+static void menu_select(void* data, int index);
+
 static void menu_click(MenuLayer* layer, MenuIndex* index, void* data) {
-  current_menu_callback(NULL, index->row);
+  menu_select(NULL, index->row);
 }
 
 static uint16_t data_num_sections(MenuLayer* layer, void* context) {
@@ -276,75 +595,185 @@ static uint16_t data_num_sections(MenuLayer* layer, void* context) {
 static int16_t data_header_height(MenuLayer* layer, uint16_t index, void* context) {
   return 20;
 }
-static GameList* get_game_list(uint16_t index, void* offset) {
-  TeamData* data = index == 0?&game_data.home:&game_data.away;
-  return (GameList*)(((char*)data) + (uint32_t)offset);
+// The open list view. The rows of each section are found when it opens and
+// the rows on screen keep their text, so scrolling only formats the row
+// coming into view. Both are redone when the event log changes.
+#define LIST_TEXT_ROWS 8
+_Static_assert(EVENT_LOG_CAPACITY <= UINT8_MAX + 1, "list rows hold event log indexes in a byte");
+
+typedef struct ListRowText_t {
+  // section << 8 | row, UINT16_MAX when empty
+  uint16_t id;
+  char title[12];
+  char subtitle[16];
+} ListRowText;
+
+// Filters the event log by team (section) and a mask of kinds
+typedef struct GameList_t {
+  uint32_t kinds;
+  uint16_t changes;
+  uint16_t counts[2];
+  // Event log index of each row, the home section first
+  uint8_t* events;
+  ListRowText text[LIST_TEXT_ROWS];
+} GameList;
+
+static GameList* s_game_list;
+
+static void game_list_build(GameList* list) {
+  int32_t heap_mark = heap_stats_mark();
+  EventLog* log = &game_data.events;
+  list->changes = event_log_changes(log);
+  list->counts[0] = list->counts[1] = 0;
+  for (uint16_t i = 0; i < event_log_size(log); ++i) {
+    Event event = event_log_get(log, i);
+    if (list->kinds & 1 << event_kind(event)) list->counts[!event_home(event)]++;
+  }
+  free(list->events);
+  list->events = malloc(list->counts[0] + list->counts[1] + 1);
+  if (!list->events) list->counts[0] = list->counts[1] = 0;
+  uint16_t next[2] = { 0, list->counts[0] };
+  for (uint16_t i = 0; list->events && i < event_log_size(log); ++i) {
+    Event event = event_log_get(log, i);
+    if (list->kinds & 1 << event_kind(event)) list->events[next[!event_home(event)]++] = i;
+  }
+  for (int i = 0; i < LIST_TEXT_ROWS; ++i) list->text[i].id = UINT16_MAX;
+  heap_stats_charge(HEAP_MENUS, heap_mark);
+}
+
+static GameList* game_list() {
+  if (s_game_list && s_game_list->changes != event_log_changes(&game_data.events)) {
+    game_list_build(s_game_list);
+  }
+  return s_game_list;
+}
+
+static void close_game_list() {
+  if (!s_game_list) return;
+  int32_t heap_mark = heap_stats_mark();
+  free(s_game_list->events);
+  free(s_game_list);
+  s_game_list = NULL;
+  heap_stats_charge(HEAP_MENUS, heap_mark);
 }
+
 static void data_draw_header(GContext* ctx, const Layer* layer, uint16_t index, void* callback) {
   menu_cell_basic_header_draw(ctx, layer, index?"Away":"Home");
 }
 
 static uint16_t games_list_menu_rows_number(MenuLayer* layer, uint16_t section, void* data) {
-  GameList* list = get_game_list(section, data);
-  if (game_list_empty(list)) return 1;
-  else return game_list_size(list);
+  GameList* list = game_list();
+  uint16_t count = list ? list->counts[section] : 0;
+  if (count == 0) return 1;
+  else return count;
 }
 
 static void games_list_draw_menu_row(GContext* ctx, const Layer* cell_layer, MenuIndex* index, void* data) {
-  GameList* list = get_game_list(index->section, data);
-  if (index->row == 0 && game_list_empty(list)) {
+  GameList* list = game_list();
+  if (!list || index->row >= list->counts[index->section]) {
     menu_cell_basic_draw(ctx, cell_layer, "None", NULL, NULL);
-  } else {
-    static char buffer[10];
-    game_list_text(list, index->row, buffer, 10);
-    menu_cell_basic_draw(ctx, cell_layer, buffer, NULL, NULL);
+    return;
   }
+  uint16_t id = index->section << 8 | index->row;
+  ListRowText* text = &list->text[(index->row + index->section * LIST_TEXT_ROWS / 2) % LIST_TEXT_ROWS];
+  if (text->id != id) {
+    uint16_t first = index->section ? list->counts[0] : 0;
+    event_row_text(event_log_get(&game_data.events, list->events[first + index->row]),
+                   text->title, sizeof(text->title), text->subtitle, sizeof(text->subtitle));
+    text->id = id;
+  }
+  menu_cell_basic_draw(ctx, cell_layer, text->title, text->subtitle, NULL);
 }
 
 static void games_list_menu_click(MenuLayer* layer, MenuIndex* index, void* data) {
   back_to_main();
 }
 
+// Scoring summary, read straight from the running totals in TeamData
+static const char* half_names[] = {"1st Half", "2nd Half"};
 
+static uint8_t summary_periods() {
+  return app_config.periods < PERIODS_MAX ? app_config.periods : PERIODS_MAX;
+}
 
-static void show_menu(const char** text, int number, MenuCallback callback) {
-  current_menu_text = text;
-  current_menu_number = number;
-  current_menu_callback = callback;
-  if (number <= 3) {
-    if (window_is_loaded(s_choice_window)) {
-      choicelayer_set_choices(s_choice_layer, text);
-      choicelayer_set_callback(s_choice_layer, callback, NULL);
-    }
-    if (window_stack_get_top_window() != s_choice_window) {
-      window_stack_push(s_choice_window, true);
-      window_stack_remove(s_menu_window, false);
-    }
+static void summary_draw_header(GContext* ctx, const Layer* layer, uint16_t index, void* data) {
+  menu_cell_basic_header_draw(ctx, layer, index ? "Halves" : "Quarters");
+}
+
+static uint16_t summary_menu_rows_number(MenuLayer* layer, uint16_t section, void* data) {
+  // The quarters section ends with overtime
+  return section ? 2 : summary_periods() + 1;
+}
+
+static void summary_draw_menu_row(GContext* ctx, const Layer* cell_layer, MenuIndex* index, void* data) {
+  static char buffer[24];
+  const char* title;
+  uint16_t away, home;
+  if (index->section == 0) {
+    uint8_t period = index->row < summary_periods() ? index->row : PERIODS_MAX;
+    title = quarter_to_text(period);
+    away = game_data.away.period_totals[period];
+    home = game_data.home.period_totals[period];
   } else {
-    if (window_is_loaded(s_menu_window)) {
-      menu_layer_set_callbacks(s_menu_layer, NULL, (MenuLayerCallbacks) {
-        .get_num_rows = get_menu_rows_number,
-        .draw_row = draw_menu_row,
-        .select_click = menu_click
-      });
-      MenuIndex index;
-      index.row = 0;
-      index.section = 0;
-      menu_layer_set_selected_index(s_menu_layer, index, MenuRowAlignTop, false);
-    }
-    if (window_stack_get_top_window() != s_menu_window){
-      window_stack_push(s_menu_window, true); 
-      window_stack_remove(s_choice_window, false);
-    } 
+    title = half_names[index->row];
+    away = game_data.away.half_totals[index->row];
+    home = game_data.home.half_totals[index->row];
+  }
+  snprintf(buffer, sizeof(buffer), "Away %d - Home %d", away, home);
+  menu_cell_basic_draw(ctx, cell_layer, title, buffer, NULL);
+}
+
+
+// Past games, read from flash a row at a time as the menu draws them
+static const int ARCHIVE_KEY = 200;
+static Archive s_archive;
+// The game open in the archive, which holds one page of its events
+static ArchiveReader* s_archive_game;
+static uint8_t s_archive_index;
+
+static void close_archive_game() {
+  if (!s_archive_game) return;
+  int32_t heap_mark = heap_stats_mark();
+  archive_close(s_archive_game);
+  s_archive_game = NULL;
+  heap_stats_charge(HEAP_MENUS, heap_mark);
+}
+
+// Keeps the game about to be reset, only for resets made on this watch
+static void archive_game() {
+  archive_init(&s_archive, ARCHIVE_KEY);
+  archive_add(&s_archive, &game_data);
+}
+
+// Shows the choice layer or the menu layer, which then takes the buttons
+static void open_menu_window(bool choice) {
+  close_game_list();
+  close_archive_game();
+  if (choice != s_choice_shown) {
+    s_choice_shown = choice;
+    layer_set_hidden(choicelayer_get_layer(s_choice_layer), !choice);
+    layer_set_hidden(menu_layer_get_layer(s_menu_layer), choice);
+    if (choice) choicelayer_set_window(s_choice_layer, s_menu_window);
+    else menu_layer_set_click_config_onto_window(s_menu_layer, s_menu_window);
+  }
+  // The menu layer is kept, so each view it shows starts from the top
+  if (!choice) {
+    menu_layer_set_selected_index(s_menu_layer, (MenuIndex) { .section = 0, .row = 0 }, MenuRowAlignTop, false);
   }
+  if (!window_stack_contains_window(s_menu_window)) window_stack_push(s_menu_window, true);
 }
 
-static void set_game_list_menu(uint32_t offset) {
-  if (window_stack_get_top_window() != s_menu_window){
-    window_stack_push(s_menu_window, true); 
-    window_stack_remove(s_choice_window, false);
+static void set_game_list_menu(uint32_t kinds) {
+  open_menu_window(false);
+  int32_t heap_mark = heap_stats_mark();
+  s_game_list = malloc(sizeof(GameList));
+  if (s_game_list) {
+    s_game_list->kinds = kinds;
+    s_game_list->events = NULL;
+    game_list_build(s_game_list);
   }
-  menu_layer_set_callbacks(s_menu_layer, (void*)offset, (MenuLayerCallbacks) {
+  heap_stats_charge(HEAP_MENUS, heap_mark);
+  menu_layer_set_callbacks(s_menu_layer, NULL, (MenuLayerCallbacks) {
     .get_num_rows = games_list_menu_rows_number,
     .draw_row = games_list_draw_menu_row,
     .select_click = games_list_menu_click,
@@ -354,130 +783,615 @@ static void set_game_list_menu(uint32_t offset) {
   });
 }
 
-static void view_menu_click(void* data, int index) {
-  switch (index) {
-    case 0: set_game_list_menu(SCORE_OFFSET); break;
-    case 1: set_game_list_menu(PENALTY_OFFSET); break;
-    case 2: back_to_main(); break;
+static void set_summary_menu() {
+  open_menu_window(false);
+  menu_layer_set_callbacks(s_menu_layer, NULL, (MenuLayerCallbacks) {
+    .get_num_rows = summary_menu_rows_number,
+    .draw_row = summary_draw_menu_row,
+    .select_click = games_list_menu_click,
+    .draw_header = summary_draw_header,
+    .get_num_sections = data_num_sections,
+    .get_header_height = data_header_height
+  });
+}
+
+// Battery use, one row per kind of activity
+static const char* activity_names[ACTIVITY_KIND_COUNT] = {
+  "Wakeups", "Redraws", "Dirty", "Vibes", "Flash writes", "Sent", "Received", "Accel batches"
+};
+
+static uint16_t activity_menu_rows_number(MenuLayer* layer, uint16_t section, void* data) {
+  return ACTIVITY_KIND_COUNT;
+}
+
+static void activity_draw_menu_row(GContext* ctx, const Layer* cell_layer, MenuIndex* index, void* data) {
+  static char buffer[32];
+  // The last whole minute, the busiest of the last ACTIVITY_MINUTES and since launch
+  snprintf(buffer, sizeof(buffer), "%u/min, peak %u, %lu", activity_minute(index->row, 1),
+           activity_peak(index->row), (unsigned long)activity.totals[index->row]);
+  menu_cell_basic_draw(ctx, cell_layer, activity_names[index->row], buffer, NULL);
+}
+
+static void set_activity_menu() {
+  open_menu_window(false);
+  menu_layer_set_callbacks(s_menu_layer, NULL, (MenuLayerCallbacks) {
+    .get_num_rows = activity_menu_rows_number,
+    .draw_row = activity_draw_menu_row,
+    .select_click = games_list_menu_click
+  });
+}
+
+// Heap use by subsystem, opened by holding the up button
+static const char* heap_subsystem_names[HEAP_SUBSYSTEM_COUNT] = {"Windows", "Layers", "Menus", "Messages"};
+
+static uint16_t heap_menu_rows_number(MenuLayer* layer, uint16_t section, void* data) {
+  return HEAP_SUBSYSTEM_COUNT + 1;
+}
+
+static void heap_draw_menu_row(GContext* ctx, const Layer* cell_layer, MenuIndex* index, void* data) {
+  static char buffer[24];
+  if (index->row < HEAP_SUBSYSTEM_COUNT) {
+    const HeapUsage* usage = &heap_stats.subsystems[index->row];
+    snprintf(buffer, sizeof(buffer), "%ld now, %ld peak", (long)usage->current, (long)usage->peak);
+    menu_cell_basic_draw(ctx, cell_layer, heap_subsystem_names[index->row], buffer, NULL);
+  } else {
+    snprintf(buffer, sizeof(buffer), "%lu peak, %lu free", (unsigned long)heap_stats.used_peak,
+             (unsigned long)heap_stats.free_low);
+    menu_cell_basic_draw(ctx, cell_layer, "Heap", buffer, NULL);
+  }
+}
+
+static void set_heap_menu() {
+  heap_stats_sample();
+  open_menu_window(false);
+  menu_layer_set_callbacks(s_menu_layer, NULL, (MenuLayerCallbacks) {
+    .get_num_rows = heap_menu_rows_number,
+    .draw_row = heap_draw_menu_row,
+    .select_click = games_list_menu_click
+  });
+}
+
+static void set_archive_game_menu(uint8_t game);
+
+static uint16_t archive_menu_rows_number(MenuLayer* layer, uint16_t section, void* data) {
+  uint8_t count = archive_count(&s_archive);
+  return count ? count : 1;
+}
+
+static void archive_draw_menu_row(GContext* ctx, const Layer* cell_layer, MenuIndex* index, void* data) {
+  static char title[24];
+  static char subtitle[16];
+  ArchiveSummary summary;
+  if (!archive_summary(&s_archive, index->row, &summary)) {
+    menu_cell_basic_draw(ctx, cell_layer, "None", NULL, NULL);
+    return;
   }
+  time_t ended = summary.ended;
+  snprintf(title, sizeof(title), "Away %u - Home %u", summary.away, summary.home);
+  strftime(subtitle, sizeof(subtitle), "%d %b %H:%M", localtime(&ended));
+  menu_cell_basic_draw(ctx, cell_layer, title, subtitle, NULL);
+}
+
+static void archive_menu_click(MenuLayer* layer, MenuIndex* index, void* data) {
+  if (index->row < archive_count(&s_archive)) set_archive_game_menu(index->row);
+}
+
+static void set_archive_menu(uint8_t row) {
+  open_menu_window(false);
+  archive_init(&s_archive, ARCHIVE_KEY);
+  menu_layer_set_callbacks(s_menu_layer, NULL, (MenuLayerCallbacks) {
+    .get_num_rows = archive_menu_rows_number,
+    .draw_row = archive_draw_menu_row,
+    .select_click = archive_menu_click
+  });
+  menu_layer_set_selected_index(s_menu_layer, (MenuIndex) { .section = 0, .row = row }, MenuRowAlignCenter, false);
+}
+
+static void archive_game_draw_header(GContext* ctx, const Layer* layer, uint16_t index, void* data) {
+  static char buffer[24];
+  // The slot may be missing or damaged, archive_open gives no reader then
+  if (!s_archive_game) {
+    menu_cell_basic_header_draw(ctx, layer, "Not kept");
+    return;
+  }
+  const ArchiveSummary* summary = archive_reader_summary(s_archive_game);
+  snprintf(buffer, sizeof(buffer), "Away %u - Home %u", summary->away, summary->home);
+  menu_cell_basic_header_draw(ctx, layer, buffer);
+}
+
+static int16_t archive_game_header_height(MenuLayer* layer, uint16_t index, void* context) {
+  return 20;
 }
 
-static void set_game_list_menu();
+static uint16_t archive_game_rows_number(MenuLayer* layer, uint16_t section, void* data) {
+  uint16_t count = s_archive_game ? archive_reader_count(s_archive_game) : 0;
+  return count ? count : 1;
+}
 
-static void main_menu_click(void* data, int index) {
-  switch (index) {
-    case 0: show_menu(new_items, 3, set_new_item); break;
-    case 1: show_menu(view_items, 3, view_menu_click); break;
-    case 2: game_data_reset(&game_data); update_display(); window_stack_pop(false); break;
+static void archive_game_draw_row(GContext* ctx, const Layer* cell_layer, MenuIndex* index, void* data) {
+  static char title[12];
+  static char subtitle[24];
+  char when[16];
+  Event event;
+  if (!s_archive_game || index->row >= archive_reader_count(s_archive_game)) {
+    menu_cell_basic_draw(ctx, cell_layer, "None", NULL, NULL);
+  } else if (!archive_reader_get(s_archive_game, index->row, &event)) {
+    menu_cell_basic_draw(ctx, cell_layer, "Not kept", NULL, NULL);
+  } else {
+    event_row_text(event, title, sizeof(title), when, sizeof(when));
+    snprintf(subtitle, sizeof(subtitle), "%s, %s", event_home(event) ? "Home" : "Away", when);
+    menu_cell_basic_draw(ctx, cell_layer, title, subtitle, NULL);
   }
 }
 
-static void clock_menu_click(void* data, int index) {
-  int seconds = 0;
-  switch (index) {
-  case 0: seconds = app_config.game_clock; break;
-  case 1: seconds = app_config.play_clock; break;
-  case 2: seconds = 90; break;
-  case 3: seconds = 60 * 20; break;
+static void archive_game_menu_click(MenuLayer* layer, MenuIndex* index, void* data) {
+  set_archive_menu(s_archive_index);
+}
+
+static void set_archive_game_menu(uint8_t game) {
+  open_menu_window(false);
+  int32_t heap_mark = heap_stats_mark();
+  s_archive_game = archive_open(&s_archive, game);
+  heap_stats_charge(HEAP_MENUS, heap_mark);
+  s_archive_index = game;
+  menu_layer_set_callbacks(s_menu_layer, NULL, (MenuLayerCallbacks) {
+    .get_num_rows = archive_game_rows_number,
+    .draw_row = archive_game_draw_row,
+    .select_click = archive_game_menu_click,
+    .draw_header = archive_game_draw_header,
+    .get_header_height = archive_game_header_height
+  });
+}
+
+static void show_menu(MenuId menu) {
+  const MenuNode* node = &s_menus[menu];
+  if (game_data.try_active && node->during_try != MENU_COUNT) {
+    menu = node->during_try;
+    node = &s_menus[menu];
+  }
+  s_menu = menu;
+  if (node->count <= 3) {
+    choicelayer_set_choices(s_choice_layer, node->labels);
+    open_menu_window(true);
+  } else {
+    open_menu_window(false);
+    menu_layer_set_callbacks(s_menu_layer, NULL, (MenuLayerCallbacks) {
+      .get_num_rows = get_menu_rows_number,
+      .draw_row = draw_menu_row,
+      .select_click = menu_click
+    });
   }
-  game_data.play_clock = index == 1?1:0;
-  game_data_timer_set_reset(&game_data, seconds);
-  game_data_timer_reset(&game_data);
-  window_stack_pop(false);
 }
 
-static void time_menu_click(void* data, int index) {
-  switch (index) {
-    case 0: game_data_timer_reset(&game_data); back_to_main(); break;
-    case 1: 
-      if (++game_data.quarter == app_config.periods / 2) {
-        game_data.home.timeouts = app_config.timeouts;
-        game_data.away.timeouts = app_config.timeouts;
+static void menu_select(void* data, int index) {
+  const MenuNode* node = &s_menus[s_menu];
+  if (index >= node->count) return;
+  const MenuItem* item = &node->items[index];
+  TRACE_INPUT();
+  TRACE_BEGIN(TRACE_MENU, s_menu << 8 | index);
+  switch (item->action) {
+    case ACTION_NONE: break;
+    case ACTION_TEAM: s_menu_home = item->arg; break;
+    case ACTION_SCORE: check_recorded(game_data_add_score(&game_data, s_menu_home, item->arg)); break;
+    case ACTION_TRY: check_recorded(game_data_add_try(&game_data, item->arg)); break;
+    case ACTION_PENALTY:
+      s_menu_home = item->arg;
+      window_stack_push(number_window_get_window(s_number_window), true);
+      break;
+    case ACTION_TIMEOUT: check_recorded(game_data_add_timeout(&game_data, item->arg)); break;
+    case ACTION_UNDO: game_data_undo(&game_data); break;
+    case ACTION_RESET_GAME:
+      archive_game();
+      game_data_reset(&game_data);
+      heap_stats_reset();
+      break;
+    case ACTION_LIST: set_game_list_menu(item->arg); break;
+    case ACTION_SUMMARY: set_summary_menu(); break;
+    case ACTION_ACTIVITY: set_activity_menu(); break;
+    case ACTION_ARCHIVE: set_archive_menu(0); break;
+    case ACTION_CLOCK_RESET: game_data_clock_reset(&game_data, game_data.shown); break;
+    case ACTION_END_QUARTER: game_data_end_quarter(&game_data); break;
+    case ACTION_CLOCK:
+      if (item->arg == CLOCK_PLAY) {
+        game_data.post_snap = false;
+        game_data_clock_set_reset(&game_data, CLOCK_PLAY, app_config.play_clock);
+        game_data_clock_reset(&game_data, CLOCK_PLAY);
       }
-      back_to_main();
+      show_clock(item->arg);
+      break;
+    case ACTION_BREAK:
+      game_data_clock_set_reset(&game_data, CLOCK_BREAK, item->arg);
+      game_data_clock_reset(&game_data, CLOCK_BREAK);
+      show_clock(CLOCK_BREAK);
       break;
-    case 2: show_menu(clock_menu_items, 4, clock_menu_click); break;
   }
+  if (item->next == MENU_BACK) {
+    update_display();
+    back_to_main();
+  } else if (item->next != MENU_HOLD) {
+    show_menu(item->next);
+  }
+  heap_stats_sample();
+  TRACE_END(TRACE_MENU, s_menu << 8 | index);
 }
 
-static void menu_window_load(Window* window) {
-  Layer* window_layer = window_get_root_layer(window);
+
+// The layers stay with the window for the life of the app
+static void create_menu_layers() {
+  int32_t heap_mark = heap_stats_mark();
+  Layer* window_layer = window_get_root_layer(s_menu_window);
   GRect bounds = layer_get_frame(window_layer);
   s_menu_layer = menu_layer_create(bounds);
-
-  menu_layer_set_click_config_onto_window(s_menu_layer, s_menu_window);
   // Needed to avoid some potential messyness
   menu_layer_set_callbacks(s_menu_layer, NULL, (MenuLayerCallbacks) {
     .get_num_rows = get_menu_rows_number,
     .draw_row = draw_menu_row,
     .select_click = menu_click
   });
+  layer_set_hidden(menu_layer_get_layer(s_menu_layer), true);
   layer_add_child(window_layer, menu_layer_get_layer(s_menu_layer));
+
+  s_choice_layer = choicelayer_create(bounds);
+  choicelayer_set_callback(s_choice_layer, menu_select, NULL);
+  choicelayer_set_choices(s_choice_layer, s_menus[s_menu].labels);
+  choicelayer_set_window(s_choice_layer, s_menu_window);
+  s_choice_shown = true;
+  layer_add_child(window_layer, choicelayer_get_layer(s_choice_layer));
+#ifdef REFWATCH_TRACE
+  s_frame_probes[1] = add_frame_probe(s_menu_window);
+#endif
+  heap_stats_charge(HEAP_MENUS, heap_mark);
 }
 
-static void menu_window_unload(Window* window) {
+static void destroy_menu_layers() {
+  int32_t heap_mark = heap_stats_mark();
   menu_layer_destroy(s_menu_layer);
+  choicelayer_destroy(s_choice_layer);
+#ifdef REFWATCH_TRACE
+  layer_destroy(s_frame_probes[1]);
+#endif
+  heap_stats_charge(HEAP_MENUS, heap_mark);
 }
 
-static void choice_window_load(Window* window) {
-  s_choice_layer = choicelayer_create_from_window(window);
-  choicelayer_set_callback(s_choice_layer, current_menu_callback, NULL);
-  choicelayer_set_choices(s_choice_layer, current_menu_text);
-  layer_add_child(window_get_root_layer(window), choicelayer_get_layer(s_choice_layer));
-}
-
-static void choice_window_unload(Window* window) {
-  choicelayer_destroy(s_choice_layer);
+// Leaving the menus frees whatever a list view was holding
+static void menu_window_disappear(Window* window) {
+  close_game_list();
+  close_archive_game();
 }
 
 static void up_click(ClickRecognizerRef re, void* ctx) {
-  if (game_data.try_active) {
-    show_menu(try_scores_items, 3, try_score);
-  } else {
-    show_menu(team_items, 2, set_team_score);
-  }
+  TRACE_INPUT();
+  TRACE_BEGIN(TRACE_CLICK, BUTTON_ID_UP);
+  show_menu(MENU_SCORE_TEAM);
+  TRACE_END(TRACE_CLICK, BUTTON_ID_UP);
 }
 
 static void middle_click(ClickRecognizerRef re, void* ctx) {
-  show_menu(main_menu_items, 3, main_menu_click);
+  TRACE_INPUT();
+  TRACE_BEGIN(TRACE_CLICK, BUTTON_ID_SELECT);
+  show_menu(MENU_MAIN);
+  TRACE_END(TRACE_CLICK, BUTTON_ID_SELECT);
+}
+
+static void up_long(ClickRecognizerRef re, void* ctx) {
+  TRACE_INPUT();
+  TRACE_BEGIN(TRACE_CLICK, 0x100 | BUTTON_ID_UP);
+  set_heap_menu();
+  TRACE_END(TRACE_CLICK, 0x100 | BUTTON_ID_UP);
 }
 
 static void down_long(ClickRecognizerRef re, void* ctx) {
-  show_menu(time_menu_items, 3, time_menu_click);
+  TRACE_INPUT();
+  TRACE_BEGIN(TRACE_CLICK, 0x100 | BUTTON_ID_DOWN);
+  show_menu(MENU_TIME);
+  TRACE_END(TRACE_CLICK, 0x100 | BUTTON_ID_DOWN);
 }
 
-static void down_click(ClickRecognizerRef re, void* ctx) {
-  if (game_data_timer_is_running(&game_data)) {
-    if (game_data.play_clock == 1 && app_config.post_snap) {
-      game_data.play_clock = 2;
-      game_data_timer_set_reset(&game_data, app_config.post_snap);
-      game_data_timer_reset(&game_data);
-      start_timer();
+// Starts or stops the shown clock, from the bottom button or a wrist tap
+static void toggle_shown_clock() {
+  ClockId clock = game_data.shown;
+  if (game_data_clock_is_running(&game_data, clock)) {
+    if (clock == CLOCK_PLAY && !game_data.post_snap && app_config.post_snap) {
+      game_data.post_snap = true;
+      game_data_clock_set_reset(&game_data, clock, app_config.post_snap);
+      game_data_clock_reset(&game_data, clock);
+      game_data_clock_start(&game_data, clock);
     } else {
-      stop_timer();
+      game_data_clock_stop(&game_data, clock);
     }
   } else {
-    if (game_data.play_clock) {
-      game_data.play_clock = 1;
-      game_data_timer_set_reset(&game_data, app_config.play_clock);
-      game_data_timer_reset(&game_data);
+    if (clock == CLOCK_PLAY) {
+      game_data.post_snap = false;
+      game_data_clock_set_reset(&game_data, clock, app_config.play_clock);
+      game_data_clock_reset(&game_data, clock);
     }
-    start_timer();
+    game_data_clock_start(&game_data, clock);
+  }
+}
+
+static void down_click(ClickRecognizerRef re, void* ctx) {
+  TRACE_INPUT();
+  TRACE_BEGIN(TRACE_CLICK, BUTTON_ID_DOWN);
+  toggle_shown_clock();
+  TRACE_END(TRACE_CLICK, BUTTON_ID_DOWN);
+}
+
+// Wrist taps work the play clock from the main window. The accelerometer is
+// only on while they can, sampling slowly and in batches so the app wakes a
+// few times a second rather than for every sample.
+static TapDetector s_tap_detector;
+static bool s_main_visible;
+static bool s_tapping;
+
+static void accel_batch(AccelData* samples, uint32_t count) {
+  activity_count(ACTIVITY_ACCEL);
+  if (!tap_detector_feed(&s_tap_detector, samples, count) || game_data.shown != CLOCK_PLAY) return;
+  TRACE_INPUT();
+  TRACE_BEGIN(TRACE_CLICK, 0x300);
+  // The official may not be looking, so the tap is felt as well as shown
+  vibes_short_pulse();
+  activity_count(ACTIVITY_VIBE);
+  toggle_shown_clock();
+  TRACE_END(TRACE_CLICK, 0x300);
+}
+
+static void update_tap_control() {
+  bool wanted = app_config.tap_control && s_main_visible && game_data.shown == CLOCK_PLAY;
+  if (wanted == s_tapping) return;
+  s_tapping = wanted;
+  if (wanted) {
+    tap_detector_init(&s_tap_detector);
+    accel_data_service_subscribe(TAP_BATCH, accel_batch);
+    accel_service_set_sampling_rate(ACCEL_SAMPLING_25HZ);
+  } else {
+    accel_data_service_unsubscribe();
+  }
+}
+
+static void main_window_appear(Window* window) {
+  s_main_visible = true;
+  update_tap_control();
+  static_settle(true);
+}
+
+static void main_window_disappear(Window* window) {
+  s_main_visible = false;
+  update_tap_control();
+  static_settle(false);
+}
+
+// A double or triple click logs the event set for it on the phone, with a
+// short pulse when taken and a double one when it cannot be. A double click
+// on a button with only a triple set has nothing to log, so is refused too.
+static void chord_click(ClickRecognizerRef re, void* ctx) {
+  TRACE_INPUT();
+  Chord chord = click_recognizer_get_button_id(re) == BUTTON_ID_UP ? CHORD_UP_DOUBLE : CHORD_SELECT_DOUBLE;
+  if (click_number_of_clicks_counted(re) >= 3) chord++;
+  TRACE_BEGIN(TRACE_CLICK, 0x200 | chord);
+  if (game_data_shortcut(&game_data, app_config.shortcuts[chord])) {
+    vibes_short_pulse();
+    update_display();
+  } else {
+    vibes_double_pulse();
   }
+  activity_count(ACTIVITY_VIBE);
+  TRACE_END(TRACE_CLICK, 0x200 | chord);
 }
 
+// Waiting to see if a second click follows holds back the single click, so
+// only buttons with a chord set wait, and the bottom one never does
+static void subscribe_chords(ButtonId button, Chord twice) {
+  uint8_t most = app_config.shortcuts[twice + 1] ? 3 : app_config.shortcuts[twice] ? 2 : 0;
+  if (most) window_multi_click_subscribe(button, 2, most, 0, true, chord_click);
+}
+
+#ifdef REFWATCH_TRACE
+static void trace_dump_click(ClickRecognizerRef re, void* ctx);
+#endif
+
 static void configure_click(void* ctx) {
   window_single_click_subscribe(BUTTON_ID_UP, up_click);
   window_single_click_subscribe(BUTTON_ID_SELECT, middle_click);
   window_single_click_subscribe(BUTTON_ID_DOWN, down_click);
   window_long_click_subscribe(BUTTON_ID_DOWN, 1000, down_long, NULL);
+  window_long_click_subscribe(BUTTON_ID_UP, 1000, up_long, NULL);
+  subscribe_chords(BUTTON_ID_UP, CHORD_UP_DOUBLE);
+  subscribe_chords(BUTTON_ID_SELECT, CHORD_SELECT_DOUBLE);
+#ifdef REFWATCH_TRACE
+  // Holding the middle button sends the trace to the phone, or stops sending
+  window_long_click_subscribe(BUTTON_ID_SELECT, 1000, trace_dump_click, NULL);
+#endif
+}
+
+static const int SYNC_KEY = 10;
+
+// Tells the phone which config fields were taken. The outbox is shared
+// with sync, so the reply waits for any frame already on its way, then
+// goes ahead of the next one. A reply the outbox will not take is tried
+// again after a growing wait, and dropped after CONFIG_FAILURES_MAX so the
+// frames held back behind it can go.
+static const int CONFIG_ACCEPTED_KEY = 7;
+static const int CONFIG_REJECTED_KEY = 8;
+#define CONFIG_RETRY_MS 500
+#define CONFIG_FAILURES_MAX 5
+static AppConfigResult s_config_reply;
+static bool s_config_reply_waiting;
+static bool s_config_reply_in_flight;
+static uint8_t s_config_reply_failures;
+static AppTimer* s_config_reply_retry;
+
+static void config_reply_retry(void* data);
+
+static void send_config_reply() {
+  if (!s_config_reply_waiting || s_config_reply_in_flight || s_config_reply_retry || s_sync.busy) return;
+  DictionaryIterator* iterator;
+  if (app_message_outbox_begin(&iterator) == APP_MSG_OK) {
+    dict_write_uint32(iterator, CONFIG_ACCEPTED_KEY, s_config_reply.accepted);
+    dict_write_uint32(iterator, CONFIG_REJECTED_KEY, s_config_reply.rejected);
+    if (app_message_outbox_send() == APP_MSG_OK) {
+      s_config_reply_waiting = false;
+      s_config_reply_in_flight = true;
+      s_config_reply_failures = 0;
+      return;
+    }
+  }
+  // Nothing is on its way to call outbox_done(), so a timer has to
+  if (++s_config_reply_failures < CONFIG_FAILURES_MAX) {
+    s_config_reply_retry = app_timer_register(CONFIG_RETRY_MS << (s_config_reply_failures - 1),
+                                              config_reply_retry, NULL);
+    return;
+  }
+  APP_LOG(APP_LOG_LEVEL_WARNING, "Config reply dropped");
+  s_config_reply_waiting = false;
+  s_config_reply_failures = 0;
+  sync_flush(&s_sync);
+}
+
+static void config_reply_retry(void* data) {
+  activity_count(ACTIVITY_WAKEUP);
+  s_config_reply_retry = NULL;
+  send_config_reply();
+}
+
+// Sync keeps frames it cannot hand over and is flushed once the reply is
+// away, so a steady stream of them cannot hold the reply back
+static bool send_sync_frame(void* context, const uint8_t* data, uint16_t size) {
+  if (s_config_reply_waiting) return false;
+  DictionaryIterator* iterator;
+  if (app_message_outbox_begin(&iterator) != APP_MSG_OK) return false;
+  dict_write_data(iterator, SYNC_KEY, data, size);
+  return app_message_outbox_send() == APP_MSG_OK;
+}
+
+#ifdef REFWATCH_TRACE
+// The trace goes to the phone a few records per message, oldest first,
+// whenever the outbox is not wanted for anything else. The first byte of
+// each part has bit 0 set on the first part and bit 1 on the last. Nothing
+// is traced until the last part is away. A lost part is sent again after a
+// growing wait, and the dump is given up after TRACE_FAILURES_MAX in a row
+// or another press of the button.
+static const int TRACE_KEY = 14;
+#define TRACE_PART_RECORDS 12
+#define TRACE_RETRY_MS 500
+#define TRACE_FAILURES_MAX 5
+static bool s_trace_dumping;
+static bool s_trace_in_flight;
+static uint16_t s_trace_next;
+static uint16_t s_trace_sending;
+static uint8_t s_trace_failures;
+static AppTimer* s_trace_retry;
+
+static void trace_dump_end() {
+  if (s_trace_retry) {
+    app_timer_cancel(s_trace_retry);
+    s_trace_retry = NULL;
+  }
+  s_trace_dumping = false;
+  trace_set_paused(false);
+}
+
+static void send_trace_part() {
+  if (!s_trace_dumping || s_trace_in_flight || s_trace_retry || s_sync.busy || s_config_reply_waiting
+      || s_config_reply_in_flight) {
+    return;
+  }
+  uint8_t part[1 + TRACE_PART_RECORDS * sizeof(TraceRecord)];
+  uint16_t count = trace_read(s_trace_next, (TraceRecord*)(part + 1), TRACE_PART_RECORDS);
+  part[0] = (s_trace_next == 0 ? 1 : 0) | (s_trace_next + count >= trace_count() ? 2 : 0);
+  DictionaryIterator* iterator;
+  if (app_message_outbox_begin(&iterator) != APP_MSG_OK) return;
+  dict_write_data(iterator, TRACE_KEY, part, 1 + count * sizeof(TraceRecord));
+  if (app_message_outbox_send() == APP_MSG_OK) {
+    s_trace_in_flight = true;
+    s_trace_sending = count;
+  }
+}
+
+static void trace_retry(void* data) {
+  activity_count(ACTIVITY_WAKEUP);
+  s_trace_retry = NULL;
+  send_trace_part();
+}
+
+static void trace_part_done(bool success) {
+  s_trace_in_flight = false;
+  if (!s_trace_dumping) return;
+  if (!success) {
+    if (++s_trace_failures >= TRACE_FAILURES_MAX) {
+      APP_LOG(APP_LOG_LEVEL_WARNING, "Trace dump given up");
+      trace_dump_end();
+    } else {
+      s_trace_retry = app_timer_register(TRACE_RETRY_MS << (s_trace_failures - 1), trace_retry, NULL);
+    }
+    return;
+  }
+  s_trace_failures = 0;
+  s_trace_next += s_trace_sending;
+  if (s_trace_next >= trace_count()) trace_dump_end();
+}
+
+static void trace_dump_click(ClickRecognizerRef re, void* ctx) {
+  if (s_trace_dumping) {
+    trace_dump_end();
+    return;
+  }
+  trace_set_paused(true);
+  s_trace_dumping = true;
+  s_trace_next = 0;
+  s_trace_failures = 0;
+  send_trace_part();
+}
+#endif
+
+// Failed sends still used the radio, so both count
+static void outbox_done(bool success) {
+  activity_count(ACTIVITY_SENT);
+  if (s_config_reply_in_flight) {
+    // Frames held back by the reply go now. A lost reply is not repeated,
+    // the phone can send the config again.
+    s_config_reply_in_flight = false;
+    sync_flush(&s_sync);
+#ifdef REFWATCH_TRACE
+  } else if (s_trace_in_flight) {
+    trace_part_done(success);
+    sync_flush(&s_sync);
+#endif
+  } else {
+    sync_sent(&s_sync, success);
+  }
+  send_config_reply();
+#ifdef REFWATCH_TRACE
+  send_trace_part();
+#endif
+}
+
+static void outbox_sent(DictionaryIterator* iterator, void* context) {
+  outbox_done(true);
+}
+
+static void outbox_failed(DictionaryIterator* iterator, AppMessageResult reason, void* context) {
+  outbox_done(false);
 }
 
 static void inbox_message(DictionaryIterator* iterator, void* context) {
-  if (app_config_reload(iterator)) {
+  activity_count(ACTIVITY_RECEIVED);
+  // Other watches' changes arrive on their own, never with config
+  Tuple* frame = dict_find(iterator, SYNC_KEY);
+  if (frame) {
+    if (sync_receive(&s_sync, frame->value->data, frame->length)) update_display();
+    return;
+  }
+  s_config_reply = app_config_reload(iterator);
+  s_config_reply_waiting = true;
+  send_config_reply();
+  if (s_config_reply.reset) {
+    archive_game();
     game_data_reset(&game_data);
-    update_display();
+    heap_stats_reset();
   }
+  // Chords and tap control may have been set or cleared
+  if (s_config_reply.changed) window_set_click_config_provider(s_main_window, configure_click);
+  if (s_config_reply.changed || s_config_reply.reset) update_display();
 }
 
 static const int GAME_DATA_KEY = 0;
@@ -487,8 +1401,13 @@ static const int AWAY_SCORE_KEY = 2;
 static void init() {
   APP_LOG(APP_LOG_LEVEL_ERROR, "In init");
   app_config_init();
+  heap_stats_init();
   app_message_register_inbox_received(inbox_message);
+  app_message_register_outbox_sent(outbox_sent);
+  app_message_register_outbox_failed(outbox_failed);
+  int32_t heap_mark = heap_stats_mark();
   app_message_open(124,124);
+  heap_stats_charge(HEAP_MESSAGES, heap_mark);
   // Create the score vectors
   game_data_init(&game_data);
   APP_LOG(APP_LOG_LEVEL_DEBUG, "Game list init");
@@ -496,46 +1415,61 @@ static void init() {
   if (!game_data_read(&game_data, GAME_DATA_KEY)) {
     game_data_reset(&game_data);
   }
+  // The worker only opens the app when the clock it was holding ran out
+  if (worker_link_take_over()) {
+    vibes_long_pulse();
+    activity_count(ACTIVITY_VIBE);
+  }
+  // A fresh id each launch tells the other watches this one may be behind
+  uint16_t milliseconds;
+  time_t seconds;
+  time_ms(&seconds, &milliseconds);
+  sync_init(&s_sync, &game_data, (uint16_t)(seconds * 1000 + milliseconds), send_sync_frame, NULL);
   APP_LOG(APP_LOG_LEVEL_DEBUG, "Creating windows");
   // Create main Window element and assign to pointer
+  heap_mark = heap_stats_mark();
   s_main_window = window_create();
   s_menu_window = window_create();
-  s_choice_window = window_create();
+  heap_stats_charge(HEAP_WINDOWS, heap_mark);
   
   APP_LOG(APP_LOG_LEVEL_DEBUG, "Set Handlers");
   // Set handlers to manage the elements inside the Window
   window_set_window_handlers(s_main_window, (WindowHandlers) {
     .load = main_window_load,
+    .appear = main_window_appear,
+    .disappear = main_window_disappear,
     .unload = main_window_unload
   });
   
   window_set_window_handlers(s_menu_window, (WindowHandlers) {
-    .load = menu_window_load,
-    .unload = menu_window_unload
-  });
-  
-  window_set_window_handlers(s_choice_window, (WindowHandlers) {
-    .load = choice_window_load,
-    .unload = choice_window_unload
+    .disappear = menu_window_disappear
   });
+  create_menu_layers();
   APP_LOG(APP_LOG_LEVEL_DEBUG, "Set click providers");
   window_set_click_config_provider(s_main_window, configure_click);
   // Show the Window on the watch, with animated=true
   APP_LOG(APP_LOG_LEVEL_DEBUG, "Push main window");
   window_stack_push(s_main_window, true);
+  heap_mark = heap_stats_mark();
   s_number_window = number_window_create(penalty_window_text,
       (NumberWindowCallbacks) {.selected = penalty_select},
       NULL);
+  heap_stats_charge(HEAP_WINDOWS, heap_mark);
 }
 
 static void deinit() {
+  sync_deinit(&s_sync);
   app_message_deregister_callbacks();
   // Destroy Window
+  int32_t heap_mark = heap_stats_mark();
   window_destroy(s_main_window);
+  destroy_menu_layers();
   window_destroy(s_menu_window);
-  window_destroy(s_choice_window);
   game_data_write(&game_data, GAME_DATA_KEY);
+  worker_link_hand_over(&game_data);
   number_window_destroy(s_number_window);
+  heap_stats_charge(HEAP_WINDOWS, heap_mark);
+  heap_stats_write();
   // Free the score list
   game_data_free(&game_data);
 }
@@ -0,0 +1,43 @@
+#include <pebble_worker.h>
+#include "ClockWorker.h"
+#include "../src/WorkerMessage.h"
+
+static void clock_worker_cancel(ClockWorker* worker) {
+  if (worker->timer) {
+    app_timer_cancel(worker->timer);
+    worker->timer = NULL;
+  }
+}
+
+// Workers cannot vibrate, the app does that when it sees why it was opened
+static void clock_worker_expired(void* context) {
+  ClockWorker* worker = (ClockWorker*)context;
+  worker->timer = NULL;
+  worker_launch_app();
+}
+
+void clock_worker_message(ClockWorker* worker, uint16_t type, AppWorkerMessage* message) {
+  if (type != WORKER_CLOCK) return;
+  clock_worker_cancel(worker);
+  uint32_t seconds = message->data0 | (uint32_t)message->data1 << 16;
+  if (!seconds && !message->data2) return;
+  time_t now_seconds;
+  uint16_t now_ms;
+  time_ms(&now_seconds, &now_ms);
+  int64_t remaining = ((int64_t)seconds - (uint32_t)now_seconds) * 1000 + message->data2 - now_ms;
+  // Ran out on the way here, the app saw it going
+  if (remaining <= 0) return;
+  worker->timer = app_timer_register((uint32_t)remaining, clock_worker_expired, worker);
+}
+
+void clock_worker_init(ClockWorker* worker) {
+  worker->timer = NULL;
+  AppWorkerMessage message;
+  if (persist_read_data(WORKER_CLOCK_KEY, &message, sizeof(message)) == sizeof(message)) {
+    clock_worker_message(worker, WORKER_CLOCK, &message);
+  }
+}
+
+void clock_worker_deinit(ClockWorker* worker) {
+  clock_worker_cancel(worker);
+}
@@ -0,0 +1,13 @@
+#pragma once
+#include <pebble_worker.h>
+
+// Holds the clock deadline while the app is closed. One timer per deadline,
+// the worker does nothing else until it fires.
+typedef struct ClockWorker_t {
+  AppTimer* timer;
+} ClockWorker;
+
+// Takes the deadline the app left in WORKER_CLOCK_KEY when it launched the worker
+void clock_worker_init(ClockWorker* worker);
+void clock_worker_message(ClockWorker* worker, uint16_t type, AppWorkerMessage* message);
+void clock_worker_deinit(ClockWorker* worker);
@@ -0,0 +1,16 @@
+#include <pebble_worker.h>
+#include "ClockWorker.h"
+
+static ClockWorker s_worker;
+
+static void worker_message(uint16_t type, AppWorkerMessage* message) {
+  clock_worker_message(&s_worker, type, message);
+}
+
+int main(void) {
+  clock_worker_init(&s_worker);
+  app_worker_message_subscribe(worker_message);
+  worker_event_loop();
+  app_worker_message_unsubscribe();
+  clock_worker_deinit(&s_worker);
+}